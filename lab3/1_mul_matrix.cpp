@@ -101,7 +101,7 @@ void multiply_parallel(int thread_count = 16) {
     for (int i = 0; i < thread_count; ++i) {
         args[i].start_row = i * rows_per_thread;
         args[i].end_row = (i == thread_count - 1) ? n : args[i].start_row + rows_per_thread;
-        pthread_create(&threads[i], nullptr, thread_multiply, &args[i]);
+        check_result(pthread_create(&threads[i], nullptr, thread_multiply, &args[i]));
     }
 
     for (auto& t : threads) //wait for threads
@@ -1,10 +1,35 @@
 #include <fcntl.h>
 #include <unistd.h>
+#include <cstring>
+#include <cstdio>
+#include <vector>
+#include "column_format.hpp"
+#include "zone_map.hpp"
+#include "packed_format.hpp"
 
-int main() {
+int main(int argc, char* argv[]) {
     int data[] = {42, 1, 2, 42, 3, 42, 4, 42, 5, 6, 42};
+    size_t n = sizeof(data) / sizeof(data[0]);
+    if (argc > 1 && strcmp(argv[1], "--packed") == 0) {
+        write_packed_file("../data.pk", data, n);
+        return 0;
+    }
+    ElementType type;
+    if (argc > 2 && strcmp(argv[1], "--type") == 0 && parse_element_type(argv[2], type)) {
+        // cung du lieu nhung ghi thanh cot co header kieu
+        dispatch_element_type(type, [&](auto tag) {
+            using T = decltype(tag);
+            std::vector<T> typed(data, data + n);
+            write_column_file("../data.col", typed.data(), n);
+            if (!write_zone_map("../data.col", build_zone_map(typed.data(), n)))
+                perror("Cannot write ../data.col.zone");
+        });
+        return 0;
+    }
     int fd = open("../data.bin", O_WRONLY | O_CREAT | O_TRUNC, 0644);
     write(fd, data, sizeof(data));
     close(fd);
+    if (!write_zone_map("../data.bin", build_zone_map(data, n)))
+        perror("Cannot write ../data.bin.zone");
     return 0;
-}
\ No newline at end of file
+}
@@ -6,94 +6,397 @@
 #include <sys/stat.h>
 #include <chrono>
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
 #include "check.hpp"
+#include "column_format.hpp"
+#include "zone_map.hpp"
+#include "packed_format.hpp"
+#include "search_kernel.hpp"
 
 const int THREADS = 16;
 const int VALUE_TO_FIND = 42;
+const size_t BLOCK_SIZE = ZONE_BLOCK_SIZE; // so phan tu giua hai lan kiem tra cancel
+const size_t PRINT_LIMIT = 64;            // file lon chi in phan dau
+const size_t RESULT_PRINT_LIMIT = 64;
 pthread_barrier_t barrier;
 
-std::vector<int> arr;
-std::vector<std::vector<int>> local_results(THREADS);
-std::vector<int> parallel_result;
-std::vector<int> sequential_result;
+enum class SearchMode { All, Exists, Count, FirstK, LastK };
+
+struct SearchQuery {
+    SearchMode mode = SearchMode::All;
+    size_t k = 0; // cho first-k / last-k
+    // tim phan tu trong [lo, hi]; giu ca dang so nguyen de int64 khong mat chinh xac qua double
+    int64_t lo_int = VALUE_TO_FIND;
+    int64_t hi_int = VALUE_TO_FIND;
+    double lo = VALUE_TO_FIND;
+    double hi = VALUE_TO_FIND;
+    bool use_zone_map = true;
+    bool type_given = false;
+    ElementType type = ElementType::Int32; // cho file khong co header
+    std::string filename = "../data.bin";
+};
+
+struct SearchResult {
+    size_t count = 0;            // so lan xuat hien (exists: 0/1)
+    std::vector<size_t> indices; // all, first-k, last-k
+
+    bool operator==(const SearchResult& other) const {
+        return count == other.count && indices == other.indices;
+    }
+};
+
+// moi thread ghi so match cua minh, cac thread khac doc de biet khi nao dung
+struct alignas(64) PaddedCount {
+    std::atomic<size_t> value{0};
+};
+
+// Du lieu phu thuoc kieu phan tu cua cot dang tim
+template <typename T>
+struct Column {
+    static inline std::vector<T> arr;
+    static inline ZoneMap<T> zone_map;
+    static inline T lo{};
+    static inline T hi{};
+    static inline bool empty_range = false; // [lo, hi] nam ngoai mien gia tri cua T
+};
+
+SearchQuery query;
+PackedFile packed; // khong rong khi input la file int32 da nen
+std::vector<std::vector<size_t>> local_results(THREADS);
+PaddedCount local_counts[THREADS];
+std::atomic<bool> cancelled{false};
+SearchResult parallel_result;
+SearchResult sequential_result;
 
 struct ThreadArg {
     int id;
-    int start;
-    int end;
+    size_t start;
+    size_t end;
 };
 
-// Đọc file nhị phân vào mảng arr
-void load_binary_file(const char* filename) {
-    int fd = check(open(filename, O_RDONLY));
-    if (fd < 0) {
-        perror("Cannot open file");
-        exit(1);
+// Chuyen [lo, hi] cua query sang kieu T
+template <typename T>
+void set_query_bounds() {
+    using Col = Column<T>;
+    if constexpr (std::is_floating_point_v<T>) {
+        Col::lo = (T)query.lo;
+        Col::hi = (T)query.hi;
+    } else {
+        int64_t lo = std::max<int64_t>(query.lo_int, std::numeric_limits<T>::min());
+        int64_t hi = std::min<int64_t>(query.hi_int, std::numeric_limits<T>::max());
+        Col::empty_range = lo > hi;
+        Col::lo = (T)lo;
+        Col::hi = (T)hi;
+    }
+}
+
+// Đọc file nhị phân vào mảng arr (bo qua offset byte header)
+template <typename T>
+void load_binary_file(int fd, off_t offset) {
+    std::vector<T>& arr = Column<T>::arr;
+    if (!packed.empty()) {
+        if constexpr (std::is_same_v<T, int32_t>) {
+            // arr chi dung cho tham chieu tuan tu; search song song chay tren du lieu nen
+            arr.resize(packed.size());
+            for (size_t b = 0; b < packed.block_count(); ++b)
+                packed.unpack_block(b, arr.data() + b * BLOCK_SIZE);
+            std::cout << "Packed data in file (" << arr.size() << " integers, " << packed.bytes() << " bytes, "
+                      << (packed.bytes() ? (double)arr.size() * sizeof(int) / packed.bytes() : 0) << "x smaller)\n";
+        }
+        return;
     }
 
     struct stat st;
     fstat(fd, &st);
-    size_t filesize = st.st_size;
-    size_t count = filesize / sizeof(int);
+    size_t filesize = st.st_size - offset;
+    size_t count = filesize / sizeof(T);
 
     arr.resize(count);
-    ssize_t read_bytes = check(read(fd, arr.data(), filesize));
-    if (read_bytes != (ssize_t)filesize) {
-        perror("Error reading file");
-        exit(1);
+    pread_all(fd, arr.data(), count * sizeof(T), offset);
+    std::cout << "Data in file (" << count << " " << element_type_name(element_type_of<T>()) << " values):\n";
+    for (size_t i = 0; i < std::min(count, PRINT_LIMIT); ++i) {
+        std::cout << +arr[i] << " ";
     }
-    close(fd);
-    std::cout << "Data in file (" << count << " integers):\n";
-    for (size_t i = 0; i < count; ++i) {
-        std::cout << arr[i] << " ";
+    std::cout << (count > PRINT_LIMIT ? "...\n" : "\n");
+}
+
+template <typename T>
+SearchResult search_sequential() {
+    using Col = Column<T>;
+    const std::vector<T>& arr = Col::arr;
+    SearchResult r;
+    if (Col::empty_range)
+        return r;
+    auto matches = [](T v) { return v >= Col::lo && v <= Col::hi; };
+    size_t n = arr.size();
+    switch (query.mode) {
+        case SearchMode::Exists:
+            r.count = std::find_if(arr.begin(), arr.end(), matches) != arr.end();
+            break;
+        case SearchMode::Count:
+            r.count = std::count_if(arr.begin(), arr.end(), matches);
+            break;
+        case SearchMode::All:
+            for (size_t i = 0; i < n; ++i)
+                if (matches(arr[i]))
+                    r.indices.push_back(i);
+            std::sort(r.indices.rbegin(), r.indices.rend());
+            break;
+        case SearchMode::FirstK:
+            for (size_t i = 0; i < n && r.indices.size() < query.k; ++i)
+                if (matches(arr[i]))
+                    r.indices.push_back(i);
+            break;
+        case SearchMode::LastK:
+            for (size_t i = n; i > 0 && r.indices.size() < query.k; --i)
+                if (matches(arr[i - 1]))
+                    r.indices.push_back(i - 1);
+            break;
     }
-    std::cout << "\n";
+    if (query.mode != SearchMode::Exists && query.mode != SearchMode::Count)
+        r.count = r.indices.size();
+    return r;
+}
+
+// Thread co the dung khi ket qua khong con phu thuoc vao chunk cua no:
+// exists da co thread tim thay, hoac cac chunk dung truoc (first-k) / sau (last-k) da du k match
+bool should_stop(int id) {
+    if (cancelled.load(std::memory_order_relaxed))
+        return true;
+    size_t ahead = 0;
+    if (query.mode == SearchMode::FirstK) {
+        for (int j = 0; j < id; ++j)
+            ahead += local_counts[j].value.load(std::memory_order_relaxed);
+    } else if (query.mode == SearchMode::LastK) {
+        for (int j = id + 1; j < THREADS; ++j)
+            ahead += local_counts[j].value.load(std::memory_order_relaxed);
+    } else {
+        return false;
+    }
+    return ahead >= query.k;
+}
+
+// Goi scan(visit) voi visit(i) ghi nhan match i theo mode;
+// tra ve false khi chunk nay khong can quet tiep
+template <typename Scan>
+bool collect_matches(int id, Scan&& scan) {
+    std::vector<size_t>& out = local_results[id];
+    std::atomic<size_t>& found = local_counts[id].value;
+    bool collect = query.mode != SearchMode::Exists && query.mode != SearchMode::Count;
+    size_t limit = query.mode == SearchMode::Exists ? 1
+                 : query.mode == SearchMode::FirstK || query.mode == SearchMode::LastK ? query.k
+                 : SIZE_MAX;
+    size_t n = found.load(std::memory_order_relaxed);
+    bool more = scan([&](size_t i) {
+        ++n;
+        if (collect)
+            out.push_back(i);
+        return n < limit;
+    });
+    found.store(n, std::memory_order_relaxed);
+    if (query.mode == SearchMode::Exists && n)
+        cancelled.store(true, std::memory_order_relaxed);
+    return more;
+}
+
+// Quet [begin, end) theo chieu cua mode bang kernel SIMD cua T, hoac truc tiep tren block da nen
+template <typename T>
+bool scan_block(int id, size_t begin, size_t end) {
+    using Col = Column<T>;
+    bool reverse = query.mode == SearchMode::LastK;
+    if constexpr (std::is_same_v<T, int32_t>) {
+        if (!packed.empty())
+            return collect_matches(id, [&](auto&& visit) {
+                return packed.for_each_match(begin / BLOCK_SIZE, Col::lo, Col::hi, reverse, visit);
+            });
+    }
+    const T* p = Col::arr.data() + begin;
+    if (query.mode == SearchMode::Count) {
+        std::atomic<size_t>& found = local_counts[id].value;
+        size_t c = SearchKernel<T>::count(p, end - begin, Col::lo, Col::hi);
+        found.store(found.load(std::memory_order_relaxed) + c, std::memory_order_relaxed);
+        return true;
+    }
+    return collect_matches(id, [&](auto&& visit) {
+        return SearchKernel<T>::for_each_match(p, begin, end - begin, Col::lo, Col::hi, reverse, visit);
+    });
 }
 
 // Thread function
+template <typename T>
 void* search_worker(void* arg) {
+    using Col = Column<T>;
     ThreadArg* t = (ThreadArg*)arg;
-    for (int i = t->start; i < t->end; ++i) {
-        if (arr[i] == VALUE_TO_FIND)
-            local_results[t->id].push_back(i);
+    size_t blocks = (t->end - t->start + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    for (size_t b = 0; b < blocks && !Col::empty_range; ++b) {
+        if (should_stop(t->id))
+            break;
+        // last-k quet tu cuoi chunk ve dau
+        size_t nb = query.mode == SearchMode::LastK ? blocks - 1 - b : b;
+        size_t begin = t->start + nb * BLOCK_SIZE;
+        size_t end = std::min(t->end, begin + BLOCK_SIZE);
+        // chunk duoc can theo BLOCK_SIZE nen block nay trung voi mot zone
+        if (!Col::zone_map.empty() && !Col::zone_map.may_contain(begin / BLOCK_SIZE, Col::lo, Col::hi))
+            continue;
+        if (!packed.empty() && !packed.may_contain(begin / BLOCK_SIZE, Col::lo, Col::hi))
+            continue;
+        if (!scan_block<T>(t->id, begin, end))
+            break;
     }
 
     pthread_barrier_wait(&barrier);
 
     if (t->id == 0) {
-        for (const auto& v : local_results)
-            parallel_result.insert(parallel_result.end(), v.begin(), v.end());
-        std::sort(parallel_result.rbegin(), parallel_result.rend());
+        SearchResult& r = parallel_result;
+        switch (query.mode) {
+            case SearchMode::Exists:
+            case SearchMode::Count:
+                for (const auto& c : local_counts)
+                    r.count += c.value.load(std::memory_order_relaxed);
+                if (query.mode == SearchMode::Exists)
+                    r.count = r.count > 0;
+                break;
+            case SearchMode::All:
+                for (const auto& v : local_results)
+                    r.indices.insert(r.indices.end(), v.begin(), v.end());
+                std::sort(r.indices.rbegin(), r.indices.rend());
+                break;
+            case SearchMode::FirstK:
+                for (const auto& v : local_results)
+                    r.indices.insert(r.indices.end(), v.begin(), v.end());
+                break;
+            case SearchMode::LastK:
+                for (auto it = local_results.rbegin(); it != local_results.rend(); ++it)
+                    r.indices.insert(r.indices.end(), it->begin(), it->end());
+                break;
+        }
+        if (query.mode == SearchMode::FirstK || query.mode == SearchMode::LastK)
+            r.indices.resize(std::min(r.indices.size(), query.k));
+        if (query.mode != SearchMode::Exists && query.mode != SearchMode::Count)
+            r.count = r.indices.size();
     }
 
     return nullptr;
 }
 
-int main() {
-    const char* filename = "../data.bin";
-    load_binary_file(filename);
+void print_result(const char* label, const SearchResult& r) {
+    std::cout << label;
+    switch (query.mode) {
+        case SearchMode::Exists:
+            std::cout << (r.count ? "found" : "not found");
+            break;
+        case SearchMode::Count:
+            std::cout << r.count << " occurrences";
+            break;
+        default:
+            for (size_t i = 0; i < std::min(r.indices.size(), RESULT_PRINT_LIMIT); ++i)
+                std::cout << r.indices[i] << " ";
+            if (r.indices.size() > RESULT_PRINT_LIMIT)
+                std::cout << "... (" << r.indices.size() << " indices)";
+    }
+    std::cout << "\n";
+}
+
+bool parse_bound(const char* text, int64_t& as_int, double& as_double, bool upper) {
+    try {
+        as_double = std::stod(text);
+        size_t used = 0;
+        as_int = std::stoll(text, &used);
+        if (text[used] != '\0') // khong phai so nguyen: lam tron vao trong khoang
+            as_int = (int64_t)(upper ? std::floor(as_double) : std::ceil(as_double));
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
+
+bool parse_query(int argc, char* argv[]) {
+    int i = 1;
+    if (i < argc && argv[i][0] != '-') {
+        std::string mode = argv[i++];
+        if (mode == "all") query.mode = SearchMode::All;
+        else if (mode == "exists") query.mode = SearchMode::Exists;
+        else if (mode == "count") query.mode = SearchMode::Count;
+        else if (mode == "first" || mode == "last") {
+            query.mode = mode == "first" ? SearchMode::FirstK : SearchMode::LastK;
+            if (i >= argc)
+                return false;
+            try {
+                query.k = std::stoul(argv[i++]);
+            } catch (...) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+    for (; i < argc; ++i) {
+        std::string opt = argv[i];
+        if (opt == "--file" && i + 1 < argc) {
+            query.filename = argv[++i];
+        } else if (opt == "--type" && i + 1 < argc) {
+            if (!parse_element_type(argv[++i], query.type))
+                return false;
+            query.type_given = true;
+        } else if (opt == "--no-zone-map") {
+            query.use_zone_map = false;
+        } else if (opt == "--range" && i + 2 < argc) {
+            if (!parse_bound(argv[i + 1], query.lo_int, query.lo, false)
+                || !parse_bound(argv[i + 2], query.hi_int, query.hi, true))
+                return false;
+            i += 2;
+        } else {
+            return false;
+        }
+    }
+    return query.lo <= query.hi;
+}
+
+template <typename T>
+int run_search(int fd, off_t offset) {
+    using Col = Column<T>;
+    const char* filename = query.filename.c_str();
+    load_binary_file<T>(fd, offset);
+    close(fd);
+    set_query_bounds<T>();
+    std::vector<T>& arr = Col::arr;
+
+    // file nen da co min/max trong header tung block
+    if (query.use_zone_map && packed.empty()) {
+        Col::zone_map = load_zone_map<T>(filename, arr.size());
+        if (Col::zone_map.empty()) {
+            // chua co zone map (hoac da cu): tao lan dau va luu lai cho lan sau
+            Col::zone_map = build_zone_map(arr.data(), arr.size());
+            std::cout << "Built zone map (" << Col::zone_map.min.size() << " blocks)\n";
+            if (!write_zone_map(filename, Col::zone_map)) // vd thu muc chi doc: van dung ban trong bo nho
+                std::cerr << "Warning: cannot save " << zone_map_path(filename) << ": " << strerror(errno) << "\n";
+        }
+    }
 
     // Tuần tự
     auto start_seq = std::chrono::high_resolution_clock::now();
-    for (size_t i = 0; i < arr.size(); ++i)
-        if (arr[i] == VALUE_TO_FIND)
-            sequential_result.push_back(i);
-    std::sort(sequential_result.rbegin(), sequential_result.rend());
+    sequential_result = search_sequential<T>();
     auto end_seq = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> duration_seq = end_seq - start_seq;
 
     // Song song
-    check(pthread_barrier_init(&barrier, nullptr, THREADS));
+    check_result(pthread_barrier_init(&barrier, nullptr, THREADS));
     pthread_t threads[THREADS];
     ThreadArg args[THREADS];
-    int chunk = (arr.size() + THREADS - 1) / THREADS;
+    size_t chunk = (arr.size() + THREADS - 1) / THREADS;
+    chunk = (chunk + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE; // can theo zone
 
     auto start_par = std::chrono::high_resolution_clock::now();
     for (int i = 0; i < THREADS; ++i) {
         args[i].id = i;
-        args[i].start = i * chunk;
-        args[i].end = std::min((int)arr.size(), args[i].start + chunk);
-        pthread_create(&threads[i], nullptr, search_worker, &args[i]);
+        args[i].start = std::min(arr.size(), i * chunk);
+        args[i].end = std::min(arr.size(), args[i].start + chunk);
+        check_result(pthread_create(&threads[i], nullptr, search_worker<T>, &args[i]));
     }
     for (int i = 0; i < THREADS; ++i)
         pthread_join(threads[i], nullptr);
@@ -102,11 +405,8 @@ int main() {
     pthread_barrier_destroy(&barrier);
 
     // In kết quả
-    std::cout << "Sequential result: ";
-    for (int i : sequential_result) std::cout << i << " ";
-    std::cout << "\nParallel result:   ";
-    for (int i : parallel_result) std::cout << i << " ";
-    std::cout << "\n";
+    print_result("Sequential result: ", sequential_result);
+    print_result("Parallel result:   ", parallel_result);
 
     std::cout << "\nTime (sequential): " << duration_seq.count() << " sec\n";
     std::cout << "Time (parallel)  : " << duration_par.count() << " sec\n";
@@ -119,4 +419,36 @@ int main() {
     }
 
     return 0;
-}
\ No newline at end of file
+}
+
+int main(int argc, char* argv[]) {
+    if (!parse_query(argc, argv)) {
+        std::cerr << "Usage: ./2_find_element [all | exists | count | first <k> | last <k>]"
+                     " [--range <lo> <hi>] [--no-zone-map] [--file <path>]"
+                     " [--type int8|int16|int32|int64|float|double]" << std::endl;
+        return 1;
+    }
+
+    int fd = check(open(query.filename.c_str(), O_RDONLY));
+
+    // kieu phan tu: header cot > file nen (luon int32) > --type
+    ElementType type = query.type;
+    off_t offset = 0;
+    ColumnFileHeader header{};
+    if (PackedFile::is_packed(fd)) {
+        type = ElementType::Int32;
+        packed.load(fd);
+    } else if (read_column_header(fd, header)) {
+        type = header.type;
+        offset = sizeof(header);
+    }
+    if (query.type_given && type != query.type) {
+        std::cerr << "File holds " << element_type_name(type) << " values, not "
+                  << element_type_name(query.type) << std::endl;
+        return 1;
+    }
+
+    return dispatch_element_type(type, [&](auto tag) {
+        return run_search<decltype(tag)>(fd, offset);
+    });
+}
@@ -0,0 +1,327 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <tuple>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "check.hpp"
+#include "column_format.hpp"
+#include "zone_map.hpp"
+#include "packed_format.hpp"
+
+// Sinh du lieu lon cho 2_find_element: moi thread sinh va ghi (pwrite) mot chunk rieng.
+// Moi block ZONE_BLOCK_SIZE co bo sinh rieng tao tu seed va chi so block, nen du lieu chi phu
+// thuoc vao seed, khong phu thuoc vao so thread (ranh gioi chunk).
+
+enum class Distribution { Uniform, Zipf, SortedRuns };
+
+struct GeneratorConfig {
+    uint64_t size_bytes = 256ull << 20;
+    ElementType type = ElementType::Int32;
+    Distribution dist = Distribution::Uniform;
+    double selectivity = 0.001; // ty le phan tu bang value
+    int64_t value = 42;         // gia tri 2_find_element se tim
+    size_t distinct = 1000000;  // mien gia tri cua uniform/zipf: [0, distinct)
+    double zipf_s = 1.0;
+    size_t run_length = 1 << 16; // do dai moi doan tang dan cua sorted
+    int threads = 16;
+    uint64_t seed = 42;
+    bool packed = false;
+    bool zone_map = true;
+    std::string out = "../data.bin";
+};
+
+const size_t BUFFER_ELEMENTS = 256 * ZONE_BLOCK_SIZE; // sinh va ghi theo tung buffer 1M phan tu
+
+GeneratorConfig cfg;
+std::vector<double> zipf_cdf;
+size_t sorted_match_first = 0; // sorted: cac phan tu bang value la doan [first, first + count)
+size_t sorted_match_count = 0;
+pthread_barrier_t barrier;
+
+struct ThreadArg {
+    int id;
+    size_t start;
+    size_t end;
+    size_t matches = 0;                  // so phan tu bang value that su da sinh
+    std::vector<uint64_t> packed;        // cac block da nen cua chunk (chi khi --packed)
+    std::vector<uint64_t> block_offsets; // offset cua tung block trong packed
+    uint64_t packed_base = 0;            // offset cua chunk trong file nen
+};
+
+std::vector<ThreadArg> args;
+
+template <typename T>
+struct Output {
+    static inline ZoneMap<T> zone_map;
+    static inline size_t count = 0;
+    static inline int fd = -1;
+};
+
+void build_zipf_cdf() {
+    zipf_cdf.resize(cfg.distinct);
+    double sum = 0;
+    for (size_t r = 0; r < cfg.distinct; ++r) {
+        sum += 1.0 / std::pow(double(r + 1), cfg.zipf_s);
+        zipf_cdf[r] = sum;
+    }
+    for (double& c : zipf_cdf)
+        c /= sum;
+}
+
+// Doan tang dan thu run: cac gia tri ngau nhien trong [run * run_length, (run + 1) * run_length) da sap xep
+void generate_run(size_t run, std::vector<int64_t>& out) {
+    std::mt19937_64 gen(cfg.seed ^ (run * 0x9e3779b97f4a7c15ull));
+    int64_t base = (int64_t)(run * cfg.run_length);
+    std::uniform_int_distribution<int64_t> dis(base, base + (int64_t)cfg.run_length - 1);
+    out.resize(cfg.run_length);
+    for (auto& v : out)
+        v = dis(gen);
+    std::sort(out.begin(), out.end());
+}
+
+// Cac doan noi tiep nhau tao thanh day khong giam, nen cac phan tu bang value cung phai nam
+// lien tiep o dung vi tri sap xep (zone map/delta moi bo qua va nen duoc): doan dai
+// selectivity * count bat dau sau moi phan tu nho hon value
+void place_sorted_matches(size_t count) {
+    size_t m = std::min<size_t>(count, (size_t)std::llround(cfg.selectivity * count));
+    size_t runs = (count + cfg.run_length - 1) / cfg.run_length;
+    size_t first;
+    if (cfg.value < 0) {
+        first = 0;
+    } else if ((uint64_t)cfg.value >= runs * cfg.run_length) {
+        first = count;
+    } else {
+        size_t home = (size_t)cfg.value / cfg.run_length; // doan co mien gia tri chua value
+        std::vector<int64_t> run;
+        generate_run(home, run);
+        first = home * cfg.run_length + (std::lower_bound(run.begin(), run.end(), cfg.value) - run.begin());
+    }
+    sorted_match_first = std::min(first, count - m);
+    sorted_match_count = m;
+}
+
+// Sinh block thu block (n phan tu) vao out; tra ve so phan tu bang value.
+// run/current_run: doan sorted dang dung, giu qua cac lan goi
+template <typename T>
+size_t generate_block(size_t block, size_t n, T* out, std::vector<int64_t>& run, size_t& current_run) {
+    std::mt19937_64 gen(cfg.seed ^ ((block + 1) * 0xbf58476d1ce4e5b9ull));
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::uniform_int_distribution<int64_t> uniform(0, (int64_t)cfg.distinct - 1);
+    size_t first = block * ZONE_BLOCK_SIZE;
+    size_t matches = 0;
+    for (size_t i = 0; i < n; ++i) {
+        int64_t v;
+        if (cfg.dist == Distribution::SortedRuns) {
+            size_t g = first + i;
+            size_t r = g / cfg.run_length;
+            if (r != current_run) {
+                generate_run(r, run);
+                current_run = r;
+            }
+            v = run[g % cfg.run_length];
+            if (g - sorted_match_first < sorted_match_count)
+                v = cfg.value;
+            else if (v == cfg.value) // chi nam ngay sau doan khop: doi len van giu thu tu
+                v = cfg.value + 1;
+        } else {
+            if (cfg.dist == Distribution::Zipf) {
+                v = std::upper_bound(zipf_cdf.begin(), zipf_cdf.end(), unit(gen)) - zipf_cdf.begin();
+                v = std::min<int64_t>(v, (int64_t)cfg.distinct - 1);
+            } else {
+                v = uniform(gen);
+            }
+            // chi value do selectivity quyet dinh; gia tri trung ngau nhien bi doi di
+            if (unit(gen) < cfg.selectivity)
+                v = cfg.value;
+            else if (v == cfg.value)
+                v = (int64_t)cfg.distinct + (v & 1);
+        }
+        T t = (T)v; // kieu hep: gia tri bi quan lai (wrap)
+        if ((int64_t)t == cfg.value && v != cfg.value)
+            t = (T)(v + 1);
+        out[i] = t;
+        matches += (int64_t)t == cfg.value;
+    }
+    return matches;
+}
+
+template <typename T>
+void* generate_worker(void* arg) {
+    ThreadArg* t = (ThreadArg*)arg;
+    using Out = Output<T>;
+    std::vector<T> buffer(BUFFER_ELEMENTS);
+    std::vector<int64_t> run;
+    size_t current_run = SIZE_MAX;
+    for (size_t first = t->start; first < t->end; first += BUFFER_ELEMENTS) {
+        size_t n = std::min(BUFFER_ELEMENTS, t->end - first);
+
+        // chunk/buffer can theo ZONE_BLOCK_SIZE nen moi block nam tron trong mot buffer
+        for (size_t b = 0; b * ZONE_BLOCK_SIZE < n; ++b) {
+            T* block = buffer.data() + b * ZONE_BLOCK_SIZE;
+            size_t len = std::min(ZONE_BLOCK_SIZE, n - b * ZONE_BLOCK_SIZE);
+            size_t zone = first / ZONE_BLOCK_SIZE + b;
+            t->matches += generate_block<T>(zone, len, block, run, current_run);
+            if (cfg.packed) {
+                if constexpr (std::is_same_v<T, int32_t>) {
+                    t->block_offsets.push_back(t->packed.size() * sizeof(uint64_t));
+                    pack_block(block, len, t->packed);
+                }
+            } else if (cfg.zone_map) {
+                std::tie(Out::zone_map.min[zone], Out::zone_map.max[zone]) = block_min_max<T>(block, block + len);
+            }
+        }
+        if (!cfg.packed)
+            pwrite_all(Out::fd, buffer.data(), n * sizeof(T), sizeof(ColumnFileHeader) + first * sizeof(T));
+    }
+
+    if (!cfg.packed)
+        return nullptr;
+
+    // file nen: offset cua block chi biet sau khi moi thread nen xong chunk cua minh
+    pthread_barrier_wait(&barrier);
+    if (t->id == 0) {
+        size_t blocks = (Out::count + ZONE_BLOCK_SIZE - 1) / ZONE_BLOCK_SIZE;
+        std::vector<uint64_t> head(sizeof(PackedFileHeader) / sizeof(uint64_t) + blocks);
+        PackedFileHeader fh{PACKED_MAGIC, (uint32_t)ZONE_BLOCK_SIZE, Out::count, blocks};
+        memcpy(head.data(), &fh, sizeof(fh));
+        uint64_t base = head.size() * sizeof(uint64_t);
+        size_t dir = sizeof(PackedFileHeader) / sizeof(uint64_t);
+        for (auto& a : args) {
+            a.packed_base = base;
+            for (uint64_t off : a.block_offsets)
+                head[dir++] = base + off;
+            base += a.packed.size() * sizeof(uint64_t);
+        }
+        pwrite_all(Out::fd, head.data(), head.size() * sizeof(uint64_t), 0);
+    }
+    pthread_barrier_wait(&barrier);
+    pwrite_all(Out::fd, t->packed.data(), t->packed.size() * sizeof(uint64_t), t->packed_base);
+    return nullptr;
+}
+
+template <typename T>
+int generate() {
+    using Out = Output<T>;
+    Out::count = cfg.size_bytes / sizeof(T);
+    size_t blocks = (Out::count + ZONE_BLOCK_SIZE - 1) / ZONE_BLOCK_SIZE;
+    if (cfg.zone_map && !cfg.packed) {
+        Out::zone_map.element_count = Out::count;
+        Out::zone_map.min.resize(blocks);
+        Out::zone_map.max.resize(blocks);
+    }
+
+    Out::fd = check(open(cfg.out.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644));
+    if (!cfg.packed) {
+        ColumnFileHeader h{COLUMN_MAGIC, element_type_of<T>(), Out::count};
+        pwrite_all(Out::fd, &h, sizeof(h), 0);
+    }
+
+    if (cfg.dist == Distribution::SortedRuns)
+        place_sorted_matches(Out::count);
+
+    // chia theo block de moi zone/block nen thuoc dung mot thread
+    size_t per_thread = (blocks + cfg.threads - 1) / cfg.threads * ZONE_BLOCK_SIZE;
+    args.resize(cfg.threads);
+    std::vector<pthread_t> threads(cfg.threads);
+    check_result(pthread_barrier_init(&barrier, nullptr, cfg.threads));
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < cfg.threads; ++i) {
+        args[i].id = i;
+        args[i].start = std::min(Out::count, i * per_thread);
+        args[i].end = std::min(Out::count, args[i].start + per_thread);
+        check_result(pthread_create(&threads[i], nullptr, generate_worker<T>, &args[i]));
+    }
+    size_t matches = 0;
+    for (int i = 0; i < cfg.threads; ++i) {
+        pthread_join(threads[i], nullptr);
+        matches += args[i].matches;
+    }
+    pthread_barrier_destroy(&barrier);
+    check(close(Out::fd));
+    if (cfg.zone_map && !cfg.packed)
+        if (!write_zone_map(cfg.out, Out::zone_map))
+            perror(("Cannot write " + zone_map_path(cfg.out)).c_str());
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> duration = end - start;
+
+    struct stat st{};
+    check(stat(cfg.out.c_str(), &st));
+    std::cout << "Wrote " << cfg.out << ": " << Out::count << " " << element_type_name(element_type_of<T>())
+              << " values, " << st.st_size << " bytes" << (cfg.packed ? " (packed)" : "") << "\n";
+    std::cout << "Value " << cfg.value << " occurs " << matches << " times (selectivity "
+              << (Out::count ? (double)matches / Out::count : 0) << ")\n";
+    std::cout << "Time: " << duration.count() << " sec ("
+              << Out::count * sizeof(T) / duration.count() / (1 << 20) << " MiB/s)\n";
+    return 0;
+}
+
+bool parse_size(const std::string& text, uint64_t& bytes) {
+    size_t used = 0;
+    double v = std::stod(text, &used);
+    std::string suffix = text.substr(used);
+    uint64_t mul = 1;
+    if (suffix == "K" || suffix == "k") mul = 1ull << 10;
+    else if (suffix == "M" || suffix == "m") mul = 1ull << 20;
+    else if (suffix == "G" || suffix == "g") mul = 1ull << 30;
+    else if (!suffix.empty()) return false;
+    bytes = (uint64_t)(v * mul);
+    return true;
+}
+
+bool parse_config(int argc, char* argv[]) {
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string opt = argv[i];
+            if (opt == "--packed") { cfg.packed = true; continue; }
+            if (opt == "--no-zone-map") { cfg.zone_map = false; continue; }
+            if (i + 1 >= argc) return false;
+            std::string val = argv[++i];
+            if (opt == "--size") {
+                if (!parse_size(val, cfg.size_bytes)) return false;
+            } else if (opt == "--type") {
+                if (!parse_element_type(val, cfg.type)) return false;
+            } else if (opt == "--dist") {
+                if (val == "uniform") cfg.dist = Distribution::Uniform;
+                else if (val == "zipf") cfg.dist = Distribution::Zipf;
+                else if (val == "sorted") cfg.dist = Distribution::SortedRuns;
+                else return false;
+            } else if (opt == "--selectivity") cfg.selectivity = std::stod(val);
+            else if (opt == "--value") cfg.value = std::stoll(val);
+            else if (opt == "--distinct") cfg.distinct = std::stoull(val);
+            else if (opt == "--zipf-s") cfg.zipf_s = std::stod(val);
+            else if (opt == "--run-length") cfg.run_length = std::stoull(val);
+            else if (opt == "--threads") cfg.threads = std::stoi(val);
+            else if (opt == "--seed") cfg.seed = std::stoull(val);
+            else if (opt == "--out") cfg.out = val;
+            else return false;
+        }
+    } catch (...) {
+        return false;
+    }
+    if (cfg.packed && cfg.type != ElementType::Int32)
+        return false; // dinh dang nen chi ho tro int32
+    return cfg.threads > 0 && cfg.distinct > 0 && cfg.run_length > 0
+        && cfg.selectivity >= 0 && cfg.selectivity <= 1;
+}
+
+int main(int argc, char* argv[]) {
+    if (!parse_config(argc, argv)) {
+        std::cerr << "Usage: ./2_generate_data [--size <bytes>[K|M|G]] [--type int8|int16|int32|int64|float|double]\n"
+                     "       [--dist uniform|zipf|sorted] [--selectivity <0..1>] [--value <v>] [--distinct <n>]\n"
+                     "       [--zipf-s <s>] [--run-length <n>] [--threads <n>] [--seed <n>] [--out <path>]\n"
+                     "       [--packed (int32 only)] [--no-zone-map]" << std::endl;
+        return 1;
+    }
+    if (cfg.dist == Distribution::Zipf)
+        build_zipf_cdf();
+    return dispatch_element_type(cfg.type, [](auto tag) {
+        return generate<decltype(tag)>();
+    });
+}
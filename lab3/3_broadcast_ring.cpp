@@ -0,0 +1,102 @@
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <pthread.h>
+#include <unistd.h>
+#include "check.hpp"
+#include "broadcast_ring.hpp"
+
+// Mot producer phat ITEMS so qua broadcast_ring, moi consumer deu nhan du:
+//  - consumer 0, 1: tinh tong va tong binh phuong mod P, doc ca dot trong ring
+//  - consumer 2: cham (ngu sau moi dot), producer phai cho no: ring khong bao gio bi ghi de
+//  - consumer 3: chi lay mau SAMPLE phan tu dau roi detach, khong con chan producer
+// Producer dong ring sau phan tu cuoi; consumer doc het phan con lai roi ket thuc.
+
+constexpr long ITEMS = 1000000;
+constexpr long P = 1000003;
+constexpr size_t CAPACITY = 1024;
+constexpr size_t BATCH = 64;
+constexpr size_t SLOW_BATCH = 256;
+constexpr useconds_t SLOW_SLEEP_US = 50;
+constexpr long SAMPLE = 1000;
+
+enum { SUM, SQUARES, SLOW, SAMPLER, CONSUMERS };
+
+broadcast_ring<long> ring(CAPACITY, CONSUMERS);
+long results[CONSUMERS];
+long received[CONSUMERS];
+
+void* consumer(void* arg) {
+    size_t id = (size_t)(intptr_t)arg;
+    long acc = 0, count = 0;
+    if (id == SAMPLER) {
+        while (count < SAMPLE) {
+            auto v = ring.receive(id);
+            if (!v)
+                break;
+            acc += *v;
+            ++count;
+        }
+        ring.detach(id);
+    } else {
+        size_t max = id == SLOW ? SLOW_BATCH : BATCH;
+        while (size_t n = ring.consume(id, [&](long v) {
+                   acc = id == SQUARES ? (acc + v * v) % P : acc + v;
+               }, max)) {
+            count += n;
+            if (id == SLOW)
+                usleep(SLOW_SLEEP_US);
+        }
+    }
+    results[id] = acc;
+    received[id] = count;
+    return nullptr;
+}
+
+int main() {
+    pthread_t threads[CONSUMERS];
+    for (int i = 0; i < CONSUMERS; ++i)
+        check_result(pthread_create(&threads[i], nullptr, consumer, (void*)(intptr_t)i));
+
+    auto start = std::chrono::high_resolution_clock::now();
+    long stalls = 0;        // so lan ring day: producer phai cho consumer cham
+    size_t max_backlog = 0; // backlog lon nhat cua consumer cham
+    std::vector<long> batch(BATCH);
+    for (long base = 0; base < ITEMS; base += BATCH) {
+        size_t len = std::min<long>(BATCH, ITEMS - base);
+        for (size_t i = 0; i < len; ++i)
+            batch[i] = base + i;
+        size_t n = ring.try_publish_bulk(batch.begin(), batch.begin() + len);
+        if (n < len) {
+            ++stalls;
+            ring.publish_bulk(batch.begin() + n, batch.begin() + len);
+        }
+        max_backlog = std::max(max_backlog, ring.backlog(SLOW));
+    }
+    ring.close();
+    for (pthread_t t : threads)
+        pthread_join(t, nullptr);
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> duration = end - start;
+
+    long sum = 0, squares = 0;
+    for (long v = 0; v < ITEMS; ++v) {
+        sum += v;
+        squares = (squares + v * v) % P;
+    }
+    long sample = SAMPLE * (SAMPLE - 1) / 2;
+    bool ok = received[SUM] == ITEMS && results[SUM] == sum
+              && received[SQUARES] == ITEMS && results[SQUARES] == squares
+              && received[SLOW] == ITEMS && results[SLOW] == sum
+              && received[SAMPLER] == SAMPLE && results[SAMPLER] == sample;
+
+    const char* names[CONSUMERS] = {"sum", "squares mod P", "slow sum", "sampler"};
+    for (int i = 0; i < CONSUMERS; ++i)
+        std::cout << "Consumer " << i << " (" << names[i] << "): " << received[i]
+                  << " items, result " << results[i] << std::endl;
+    std::cout << "Producer stalls: " << stalls << ", max backlog of slow consumer: " << max_backlog
+              << " / " << ring.capacity() << std::endl;
+    std::cout << (ok ? "OK" : "MISMATCH") << std::endl;
+    std::cout << "Time: " << duration.count() << " s" << std::endl;
+    return ok ? 0 : 1;
+}
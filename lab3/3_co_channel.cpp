@@ -0,0 +1,81 @@
+#include <iostream>
+#include <chrono>
+#include <atomic>
+#include "co_channel.hpp"
+
+// Pipeline hai tang bang coroutine: PRODUCERS coroutine sinh so -> kenh -> WORKERS coroutine
+// binh phuong -> kenh -> SINKS coroutine cong don. Hang nghin coroutine chay tren THREADS thread.
+// Coroutine cuoi cung cua moi tang dong kenh phia sau de tang tiep theo ket thuc.
+
+constexpr int THREADS = 4;
+constexpr int PRODUCERS = 1000;
+constexpr int WORKERS = 2000;
+constexpr int SINKS = 500;
+constexpr long ITEMS = 200; // moi producer
+constexpr size_t CHANNEL_CAPACITY = 64;
+
+std::atomic<int> producers_left{PRODUCERS};
+std::atomic<int> workers_left{WORKERS};
+std::atomic<long> total{0};
+std::atomic<long> received{0};
+
+co_task producer(co_channel<long>& out, long id) {
+    for (long i = 0; i < ITEMS; ++i)
+        co_await out.push(id * ITEMS + i);
+    if (producers_left.fetch_sub(1) == 1)
+        out.close();
+}
+
+co_task worker(co_channel<long>& in, co_channel<long>& out) {
+    while (auto v = co_await in.pop())
+        co_await out.push(*v * *v % 1000003);
+    if (workers_left.fetch_sub(1) == 1)
+        out.close();
+}
+
+co_task sink(co_channel<long>& in) {
+    long sum = 0, count = 0;
+    while (auto v = co_await in.pop()) {
+        sum += *v;
+        ++count;
+    }
+    total += sum;
+    received += count;
+}
+
+int main() {
+    auto start = std::chrono::high_resolution_clock::now();
+    {
+        executor exec(THREADS);
+        co_channel<long> numbers(exec, CHANNEL_CAPACITY);
+        co_channel<long> squares(exec, CHANNEL_CAPACITY);
+        bool spawned = true;
+        for (int i = 0; spawned && i < SINKS; ++i)
+            spawned = exec.spawn(sink(squares));
+        for (int i = 0; spawned && i < WORKERS; ++i)
+            spawned = exec.spawn(worker(numbers, squares));
+        for (int i = 0; spawned && i < PRODUCERS; ++i)
+            spawned = exec.spawn(producer(numbers, i));
+        if (!spawned) {
+            // thieu coroutine thi pipeline khong bao gio xong: dong kenh de cac coroutine da chay ket thuc
+            std::cerr << "Executor is full: too many coroutines" << std::endl;
+            numbers.close();
+            squares.close();
+        }
+        exec.wait();
+        if (!spawned)
+            return 1;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> duration = end - start;
+
+    long expected = 0;
+    for (long v = 0; v < PRODUCERS * ITEMS; ++v)
+        expected += v * v % 1000003;
+
+    std::cout << PRODUCERS + WORKERS + SINKS << " coroutines on " << THREADS << " threads" << std::endl;
+    std::cout << "Received " << received << " items, sum " << total
+              << (total == expected ? " (OK)" : " (MISMATCH)") << std::endl;
+    std::cout << "Time: " << duration.count() << " s" << std::endl;
+    return total == expected ? 0 : 1;
+}
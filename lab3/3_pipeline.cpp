@@ -0,0 +1,55 @@
+#include <iostream>
+#include <chrono>
+#include <atomic>
+#include <optional>
+#include "pipeline.hpp"
+
+// Pipeline 4 tang: sinh so -> loc so nguyen to (4 thread) -> binh phuong mod P (2 thread) -> cong don.
+// In so lieu tung tang moi 500ms va kiem tra tong voi cach tinh tuan tu.
+
+constexpr long LIMIT = 1000000;
+constexpr long P = 1000003;
+constexpr size_t QUEUE_CAPACITY = 1024;
+
+bool is_prime(long n) {
+    if (n < 2)
+        return false;
+    for (long d = 2; d * d <= n; ++d)
+        if (n % d == 0)
+            return false;
+    return true;
+}
+
+int main() {
+    std::atomic<long> next{0};
+    long total = 0;
+
+    pipeline p(QUEUE_CAPACITY);
+    auto numbers = p.source<long>("generate", 1, [&]() -> std::optional<long> {
+        long n = next.fetch_add(1, std::memory_order_relaxed);
+        if (n >= LIMIT)
+            return std::nullopt;
+        return n;
+    });
+    auto primes = p.transform<long>("filter primes", 4, numbers, [](long n) -> std::optional<long> {
+        if (!is_prime(n))
+            return std::nullopt;
+        return n;
+    });
+    auto squares = p.transform<long>("square mod", 2, primes, [](long n) { return n * n % P; });
+    p.sink("sum", 1, squares, [&](long v) { total += v; });
+
+    auto start = std::chrono::high_resolution_clock::now();
+    p.run(std::chrono::milliseconds(500));
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> duration = end - start;
+
+    long expected = 0;
+    for (long n = 0; n < LIMIT; ++n)
+        if (is_prime(n))
+            expected += n * n % P;
+
+    std::cout << "Sum: " << total << (total == expected ? " (OK)" : " (MISMATCH)") << std::endl;
+    std::cout << "Time: " << duration.count() << " s" << std::endl;
+    return total == expected ? 0 : 1;
+}
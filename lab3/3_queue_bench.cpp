@@ -0,0 +1,332 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <chrono>
+#include <optional>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include "check.hpp"
+#include "mt_queue.hpp"
+#include "mpmc_ring.hpp"
+#include "sharded_queue.hpp"
+#include "mpsc_queue.hpp"
+
+// Benchmark cac hang doi lab3: quet so producer/consumer, dung luong, kich thuoc phan tu va loai hang doi.
+// In ra thong luong (ops/s) va phan vi do tre tu luc enqueue den luc dequeue.
+
+struct BenchConfig {
+    std::vector<std::string> queues = {"mutex", "mutex-futex", "spsc", "ring", "sharded", "mpsc"};
+    std::vector<int> producers = {1, 2, 4};
+    std::vector<int> consumers = {1, 2, 4};
+    std::vector<size_t> capacities = {64, 1024};
+    std::vector<size_t> item_sizes = {8, 256};
+    size_t items = 200000; // moi producer
+    bool pin = false;
+};
+
+BenchConfig cfg;
+
+uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Histogram log-tuyen tinh kieu HdrHistogram: moi khoang [2^e, 2^(e+1)) chia thanh 2^SUB_BITS o deu nhau,
+// sai so tuong doi toi da 1/2^SUB_BITS (~3%) tren moi khoang gia tri, bo nho co dinh
+class LatencyHistogram {
+    static constexpr int SUB_BITS = 5;
+    static constexpr uint64_t SUB_COUNT = 1ull << SUB_BITS;
+    static constexpr size_t BUCKETS = (64 - SUB_BITS + 1) * SUB_COUNT;
+    std::vector<uint64_t> counts_ = std::vector<uint64_t>(BUCKETS);
+    uint64_t total_ = 0;
+    uint64_t max_ = 0;
+
+    static size_t index_of(uint64_t v) {
+        if (v < SUB_COUNT)
+            return v;
+        int e = 63 - __builtin_clzll(v); // >= SUB_BITS
+        return (size_t)(e - SUB_BITS + 1) * SUB_COUNT + ((v >> (e - SUB_BITS)) & (SUB_COUNT - 1));
+    }
+
+    // can duoi cua o
+    static uint64_t value_of(size_t i) {
+        if (i < SUB_COUNT)
+            return i;
+        int e = (int)(i / SUB_COUNT) + SUB_BITS - 1;
+        return (SUB_COUNT + i % SUB_COUNT) << (e - SUB_BITS);
+    }
+
+public:
+    void record(uint64_t v) {
+        ++counts_[index_of(v)];
+        ++total_;
+        if (v > max_)
+            max_ = v;
+    }
+
+    void merge(const LatencyHistogram& o) {
+        for (size_t i = 0; i < BUCKETS; ++i)
+            counts_[i] += o.counts_[i];
+        total_ += o.total_;
+        max_ = std::max(max_, o.max_);
+    }
+
+    uint64_t percentile(double p) const {
+        uint64_t rank = (uint64_t)(p / 100.0 * total_);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            seen += counts_[i];
+            if (seen > rank)
+                return value_of(i);
+        }
+        return max_;
+    }
+
+    uint64_t max() const { return max_; }
+};
+
+template <size_t Size>
+struct Item {
+    uint64_t stamp; // now_ns() luc enqueue
+    char payload[Size - sizeof(uint64_t)];
+};
+
+template <>
+struct Item<sizeof(uint64_t)> {
+    uint64_t stamp;
+};
+
+// Giao dien chung: sharded_queue can biet consumer nao dang lay
+template <typename Q>
+auto pop(Q& q, int) { return q.dequeue(); }
+
+template <typename T, typename W>
+auto pop(sharded_queue<T, W>& q, int id) { return q.dequeue(id); }
+
+template <typename Q>
+struct queue_factory {
+    static Q* make(size_t capacity, int) { return new Q(capacity); }
+};
+
+template <typename T, typename W>
+struct queue_factory<sharded_queue<T, W>> {
+    // moi consumer mot shard, tong dung luong bang cac hang doi khac
+    static sharded_queue<T, W>* make(size_t capacity, int consumers) {
+        return new sharded_queue<T, W>(consumers, std::max<size_t>(1, capacity / consumers));
+    }
+};
+
+template <typename T, typename W>
+struct queue_factory<mpsc_queue<T, W>> {
+    // khong gioi han: bo qua dung luong
+    static mpsc_queue<T, W>* make(size_t, int) { return new mpsc_queue<T, W>(); }
+};
+
+struct RunResult {
+    double ops_per_sec;
+    LatencyHistogram latency;
+};
+
+void pin_thread(int index) {
+    static const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(index % cpus, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set); // chi la goi y: cpuset co the khong cho cpu nay
+}
+
+template <typename Q, typename I>
+struct BenchState {
+    Q* queue;
+    pthread_barrier_t start;
+    std::vector<LatencyHistogram> latency; // moi consumer mot histogram, gop lai sau
+};
+
+template <typename Q, typename I>
+struct BenchArg {
+    BenchState<Q, I>* state;
+    int id; // producer: 0..P-1, consumer: P..P+C-1
+    int consumer_id;
+};
+
+template <typename Q, typename I>
+void* bench_producer(void* arg) {
+    auto* a = (BenchArg<Q, I>*)arg;
+    if (cfg.pin)
+        pin_thread(a->id);
+    I item;
+    memset(&item, 0, sizeof(item));
+    pthread_barrier_wait(&a->state->start);
+    for (size_t i = 0; i < cfg.items; ++i) {
+        item.stamp = now_ns();
+        a->state->queue->enqueue(item);
+    }
+    return nullptr;
+}
+
+template <typename Q, typename I>
+void* bench_consumer(void* arg) {
+    auto* a = (BenchArg<Q, I>*)arg;
+    if (cfg.pin)
+        pin_thread(a->id);
+    LatencyHistogram& h = a->state->latency[a->consumer_id];
+    pthread_barrier_wait(&a->state->start);
+    while (auto item = pop(*a->state->queue, a->consumer_id))
+        h.record(now_ns() - item->stamp);
+    return nullptr;
+}
+
+template <typename Q, typename I>
+RunResult run_bench(int producers, int consumers, size_t capacity) {
+    BenchState<Q, I> state;
+    state.queue = queue_factory<Q>::make(capacity, consumers);
+    state.latency.resize(consumers);
+    int threads = producers + consumers;
+    check_result(pthread_barrier_init(&state.start, nullptr, threads + 1));
+
+    std::vector<pthread_t> tids(threads);
+    std::vector<BenchArg<Q, I>> args(threads);
+    for (int i = 0; i < threads; ++i) {
+        args[i] = {&state, i, i - producers};
+        check_result(pthread_create(&tids[i], nullptr, i < producers ? bench_producer<Q, I> : bench_consumer<Q, I>, &args[i]));
+    }
+
+    pthread_barrier_wait(&state.start);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < producers; ++i)
+        pthread_join(tids[i], nullptr);
+    state.queue->close();
+    for (int i = producers; i < threads; ++i)
+        pthread_join(tids[i], nullptr);
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> duration = end - start;
+
+    check_result(pthread_barrier_destroy(&state.start));
+    delete state.queue;
+
+    RunResult r{(double)producers * cfg.items / duration.count(), {}};
+    for (auto& h : state.latency)
+        r.latency.merge(h);
+    return r;
+}
+
+template <typename I>
+std::optional<RunResult> run_queue(const std::string& name, int producers, int consumers, size_t capacity) {
+    if (name == "mutex")
+        return run_bench<mt_queue<I>, I>(producers, consumers, capacity);
+    if (name == "mutex-futex")
+        return run_bench<mt_queue<I, mpmc, spin_futex_wait<>>, I>(producers, consumers, capacity);
+    if (name == "spsc") {
+        if (producers != 1 || consumers != 1)
+            return std::nullopt; // chi dung voi 1P/1C
+        return run_bench<mt_queue<I, spsc, spin_futex_wait<>>, I>(producers, consumers, capacity);
+    }
+    if (name == "ring")
+        return run_bench<mpmc_ring<I>, I>(producers, consumers, capacity);
+    if (name == "sharded")
+        return run_bench<sharded_queue<I>, I>(producers, consumers, capacity);
+    if (name == "mpsc") {
+        if (consumers != 1)
+            return std::nullopt; // chi dung voi 1 consumer
+        return run_bench<mpsc_queue<I>, I>(producers, consumers, capacity);
+    }
+    return std::nullopt;
+}
+
+template <typename F>
+bool dispatch_item_size(size_t size, F&& f) {
+    switch (size) {
+        case 8: f(Item<8>{}); return true;
+        case 64: f(Item<64>{}); return true;
+        case 256: f(Item<256>{}); return true;
+        case 1024: f(Item<1024>{}); return true;
+        case 4096: f(Item<4096>{}); return true;
+        default: return false;
+    }
+}
+
+template <typename T>
+bool parse_list(const std::string& text, std::vector<T>& out) {
+    out.clear();
+    std::stringstream ss(text);
+    std::string part;
+    while (std::getline(ss, part, ',')) {
+        if (part.empty())
+            return false;
+        if constexpr (std::is_same_v<T, std::string>)
+            out.push_back(part);
+        else
+            out.push_back((T)std::stoull(part));
+    }
+    return !out.empty();
+}
+
+bool parse_config(int argc, char* argv[]) {
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string opt = argv[i];
+            if (opt == "--pin") { cfg.pin = true; continue; }
+            if (i + 1 >= argc) return false;
+            std::string val = argv[++i];
+            if (opt == "--queue") {
+                if (!parse_list(val, cfg.queues)) return false;
+            } else if (opt == "--producers") {
+                if (!parse_list(val, cfg.producers)) return false;
+            } else if (opt == "--consumers") {
+                if (!parse_list(val, cfg.consumers)) return false;
+            } else if (opt == "--capacity") {
+                if (!parse_list(val, cfg.capacities)) return false;
+            } else if (opt == "--item-size") {
+                if (!parse_list(val, cfg.item_sizes)) return false;
+            } else if (opt == "--items") cfg.items = std::stoull(val);
+            else return false;
+        }
+    } catch (...) {
+        return false;
+    }
+    for (int n : cfg.producers)
+        if (n <= 0) return false;
+    for (int n : cfg.consumers)
+        if (n <= 0) return false;
+    for (size_t c : cfg.capacities)
+        if (c == 0) return false;
+    for (size_t s : cfg.item_sizes)
+        if (!dispatch_item_size(s, [](auto) {})) return false;
+    return cfg.items > 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (!parse_config(argc, argv)) {
+        std::cerr << "Usage: ./3_queue_bench [--queue mutex,mutex-futex,spsc,ring,sharded,mpsc] [--producers 1,2,4]\n"
+                     "       [--consumers 1,2,4] [--capacity 64,1024] [--item-size 8|64|256|1024|4096,...]\n"
+                     "       [--items <per producer>] [--pin]" << std::endl;
+        return 1;
+    }
+
+    std::cout << std::left << std::setw(12) << "queue" << std::right
+              << std::setw(4) << "P" << std::setw(4) << "C" << std::setw(8) << "cap" << std::setw(7) << "item"
+              << std::setw(14) << "ops/s" << std::setw(10) << "p50 ns" << std::setw(10) << "p90 ns"
+              << std::setw(10) << "p99 ns" << std::setw(11) << "p99.9 ns" << std::setw(12) << "max ns" << "\n";
+    for (size_t size : cfg.item_sizes)
+        for (const std::string& name : cfg.queues)
+            for (int p : cfg.producers)
+                for (int c : cfg.consumers)
+                    for (size_t cap : cfg.capacities)
+                        dispatch_item_size(size, [&](auto tag) {
+                            auto r = run_queue<decltype(tag)>(name, p, c, cap);
+                            if (!r)
+                                return;
+                            const LatencyHistogram& h = r->latency;
+                            std::cout << std::left << std::setw(12) << name << std::right
+                                      << std::setw(4) << p << std::setw(4) << c << std::setw(8) << cap
+                                      << std::setw(7) << size << std::setw(14) << (uint64_t)r->ops_per_sec
+                                      << std::setw(10) << h.percentile(50) << std::setw(10) << h.percentile(90)
+                                      << std::setw(10) << h.percentile(99) << std::setw(11) << h.percentile(99.9)
+                                      << std::setw(12) << h.max() << std::endl;
+                        });
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include <iostream>
+#include <chrono>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "check.hpp"
+#include "shm_queue.hpp"
+
+// Producer (process cha) gui tin qua shm_queue cho N process con. Moi con mo hang doi theo ten
+// nhu mot process doc lap va gui ket qua ve qua hang doi thu hai.
+
+constexpr int N = 3;            // so process consumer
+constexpr int ITEMS = 1000000;  // so tin process cha gui
+constexpr int QUEUE_CAPACITY = 1024;
+const char* QUEUE_NAME = "/lab3_shm_queue";
+const char* RESULT_NAME = "/lab3_shm_result";
+
+struct Message {
+    int seq;
+    char payload[60]; // tin 64 byte
+};
+
+struct Result {
+    pid_t pid;
+    long count;
+    long sum;
+};
+
+int consumer() {
+    shm_queue<Message> queue = shm_queue<Message>::open(QUEUE_NAME);
+    shm_queue<Result> results = shm_queue<Result>::open(RESULT_NAME);
+    Result r{getpid(), 0, 0};
+    while (auto msg = queue.dequeue()) {
+        ++r.count;
+        r.sum += msg->seq;
+    }
+    results.enqueue(r);
+    return 0;
+}
+
+int main() {
+    // ten rieng cua demo: segment con lai la tu lan chay truoc bi ngat, thay the duoc
+    shm_queue<Message> queue = shm_queue<Message>::create(QUEUE_NAME, QUEUE_CAPACITY, true);
+    shm_queue<Result> results = shm_queue<Result>::create(RESULT_NAME, N, true);
+
+    pid_t children[N];
+    for (int i = 0; i < N; ++i) {
+        children[i] = check(fork());
+        if (children[i] == 0)
+            exit(consumer());
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    Message msg{};
+    for (int i = 0; i < ITEMS; ++i) {
+        msg.seq = i;
+        queue.enqueue(msg);
+    }
+    queue.close(); // con lay not phan con lai roi nhan nullopt
+
+    long count = 0, sum = 0;
+    for (int i = 0; i < N; ++i) {
+        Result r = *results.dequeue();
+        std::cout << "[Consumer " << r.pid << "] received " << r.count << " messages" << std::endl;
+        count += r.count;
+        sum += r.sum;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> duration = end - start;
+
+    for (int i = 0; i < N; ++i) {
+        int status;
+        check(waitpid(children[i], &status, 0));
+    }
+    shm_queue<Message>::unlink(QUEUE_NAME);
+    shm_queue<Result>::unlink(RESULT_NAME);
+
+    bool ok = count == ITEMS && sum == (long)ITEMS * (ITEMS - 1) / 2;
+    std::cout << (ok ? "All messages delivered." : "Messages lost!") << "\n";
+    std::cout << "Time: " << duration.count() << " sec (" << ITEMS / duration.count() << " msg/s)" << std::endl;
+    return ok ? 0 : 1;
+}
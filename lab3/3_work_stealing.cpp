@@ -0,0 +1,105 @@
+#include <iostream>
+#include <chrono>
+#include <atomic>
+#include <vector>
+#include <random>
+#include <pthread.h>
+#include <sched.h>
+#include "check.hpp"
+#include "chase_lev_deque.hpp"
+
+// Fork-join dem so nguyen to trong [0, LIMIT) bang chase_lev_deque: moi thread mot deque.
+// Task la mot doan; doan lon hon GRAIN duoc chia doi, nua sau day vao deque cua minh (push),
+// lam tiep nua dau. Thread lay viec o deque cua minh theo LIFO (pop), het viec thi lay
+// doan cu nhat (lon nhat) tu deque cua thread khac (steal). Ban dau chi thread 0 co viec.
+
+constexpr int THREADS = 4;
+constexpr long LIMIT = 2000000;
+constexpr long GRAIN = 1000;
+
+struct task {
+    long lo, hi;
+};
+
+struct worker_state {
+    chase_lev_deque<task*> deque;
+    long primes = 0;
+    long executed = 0; // so task da chay
+    long steals = 0;   // so task lay tu deque khac
+};
+
+std::vector<worker_state> workers(THREADS);
+std::atomic<long> remaining{LIMIT}; // so phan tu chua xu ly: 0 thi moi thread dung
+
+bool is_prime(long n) {
+    if (n < 2)
+        return false;
+    for (long d = 2; d * d <= n; ++d)
+        if (n % d == 0)
+            return false;
+    return true;
+}
+
+void run(worker_state& self, task* t) {
+    while (t->hi - t->lo > GRAIN) {
+        long mid = t->lo + (t->hi - t->lo) / 2;
+        self.deque.push(new task{mid, t->hi});
+        t->hi = mid;
+    }
+    for (long n = t->lo; n < t->hi; ++n)
+        self.primes += is_prime(n);
+    ++self.executed;
+    remaining.fetch_sub(t->hi - t->lo, std::memory_order_acq_rel);
+    delete t;
+}
+
+void* worker(void* arg) {
+    int id = (int)(intptr_t)arg;
+    worker_state& self = workers[id];
+    std::mt19937 gen(id);
+    std::uniform_int_distribution<int> victim(0, THREADS - 1);
+    while (remaining.load(std::memory_order_acquire) > 0) {
+        if (auto t = self.deque.pop()) {
+            run(self, *t);
+            continue;
+        }
+        int v = victim(gen);
+        if (v == id)
+            continue;
+        if (auto t = workers[v].deque.steal()) {
+            ++self.steals;
+            run(self, *t);
+        } else {
+            sched_yield();
+        }
+    }
+    return nullptr;
+}
+
+int main() {
+    workers[0].deque.push(new task{0, LIMIT}); // truoc khi tao thread: deque chi owner ghi
+
+    auto start = std::chrono::high_resolution_clock::now();
+    pthread_t threads[THREADS];
+    for (int i = 0; i < THREADS; ++i)
+        check_result(pthread_create(&threads[i], nullptr, worker, (void*)(intptr_t)i));
+    for (pthread_t t : threads)
+        pthread_join(t, nullptr);
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> duration = end - start;
+
+    long total = 0;
+    for (int i = 0; i < THREADS; ++i) {
+        total += workers[i].primes;
+        std::cout << "Thread " << i << ": " << workers[i].executed << " tasks, "
+                  << workers[i].steals << " stolen" << std::endl;
+    }
+
+    long expected = 0;
+    for (long n = 0; n < LIMIT; ++n)
+        expected += is_prime(n);
+
+    std::cout << "Primes: " << total << (total == expected ? " (OK)" : " (MISMATCH)") << std::endl;
+    std::cout << "Time: " << duration.count() << " s" << std::endl;
+    return total == expected ? 0 : 1;
+}
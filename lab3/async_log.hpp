@@ -0,0 +1,261 @@
+#ifndef ASYNC_LOG_HPP
+#define ASYNC_LOG_HPP
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <string_view>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <climits>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include "check.hpp"
+#include "mt_queue.hpp"
+
+// Ghi log bat dong bo: moi thread ghi ban ghi da dinh dang vao ring spsc rieng cua minh
+// (khong khoa, khong cap phat, khong syscall), mot thread nen gom ban ghi tu moi ring
+// va ghi ra fd bang writev theo tung dot. Ring day thi thread ghi log cho (khong mat log).
+// Sau fork(), process con bo ban ghi cua process cha (da duoc flush truoc khi fork)
+// va tu khoi dong thread ghi rieng o lan log dau tien.
+class async_logger {
+public:
+    static constexpr size_t RECORD_TEXT = 253;   // ca '\n'; dong dai hon duoc tach thanh nhieu ban ghi
+    static constexpr size_t RING_RECORDS = 1024; // moi thread
+    static constexpr size_t BATCH = IOV_MAX < 1024 ? IOV_MAX : 1024;
+    static constexpr useconds_t IDLE_SLEEP_US = 1000;
+
+    struct record {
+        uint16_t len;
+        bool more; // dong con tiep o ban ghi sau trong cung ring
+        char text[RECORD_TEXT];
+    };
+
+    // Logger cua process, ghi ra stdout; chi logger nay duoc xu ly khi fork
+    static async_logger& instance() {
+        static async_logger logger(STDOUT_FILENO);
+        static int registered = pthread_atfork(fork_prepare, fork_parent, fork_child);
+        (void)registered;
+        return logger;
+    }
+
+    explicit async_logger(int fd) : fd_(fd), batch_(BATCH) {
+        pthread_mutex_init(&registry_mutex_, nullptr);
+        pthread_mutex_init(&drain_mutex_, nullptr);
+    }
+
+    async_logger(const async_logger&) = delete;
+
+    ~async_logger() {
+        if (running_) {
+            stop_.store(true, std::memory_order_relaxed);
+            pthread_join(thread_, nullptr);
+        }
+        flush();
+        pthread_mutex_destroy(&registry_mutex_);
+        pthread_mutex_destroy(&drain_mutex_);
+    }
+
+    // Them mot dong (tu them '\n')
+    void log(std::string_view msg) {
+        ring& r = local_ring();
+        do {
+            record rec;
+            size_t n = std::min(msg.size(), RECORD_TEXT - 1);
+            memcpy(rec.text, msg.data(), n);
+            msg.remove_prefix(n);
+            rec.more = !msg.empty();
+            if (!rec.more)
+                rec.text[n++] = '\n';
+            rec.len = (uint16_t)n;
+            r.enqueue(rec);
+        } while (!msg.empty());
+    }
+
+    // Dinh dang thang vao ban ghi; dong dai hon RECORD_TEXT - 1 bi cat
+    __attribute__((format(printf, 2, 3)))
+    void logf(const char* fmt, ...) {
+        record rec;
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(rec.text, RECORD_TEXT, fmt, ap);
+        va_end(ap);
+        if (n < 0)
+            return;
+        n = std::min<int>(n, RECORD_TEXT - 1);
+        rec.text[n] = '\n';
+        rec.len = (uint16_t)(n + 1);
+        rec.more = false;
+        local_ring().enqueue(rec);
+    }
+
+    // Ghi ra moi ban ghi da co truoc luc goi
+    void flush() {
+        check_result(pthread_mutex_lock(&drain_mutex_));
+        while (drain() > 0) {}
+        check_result(pthread_mutex_unlock(&drain_mutex_));
+    }
+
+private:
+    using ring = mt_queue<record, spsc, spin_futex_wait<>>;
+
+    struct thread_ring {
+        ring queue{RING_RECORDS};
+        std::atomic<bool> orphaned{false}; // thread ghi da ket thuc: xoa khi rong
+    };
+
+    // Con tro thread_local toi ring cua thread; danh dau ring mo coi khi thread ket thuc
+    struct local_handle {
+        thread_ring* r = nullptr;
+        async_logger* owner = nullptr;
+        uint64_t generation = 0;
+        ~local_handle() {
+            if (r)
+                r->orphaned.store(true, std::memory_order_release);
+        }
+    };
+
+    int fd_;
+    pthread_mutex_t registry_mutex_; // bao ve rings_, running_
+    pthread_mutex_t drain_mutex_;    // chi mot ben doc cac ring (spsc) tai mot thoi diem
+    std::vector<std::unique_ptr<thread_ring>> rings_;
+    std::vector<std::unique_ptr<thread_ring>> retired_; // ring cua process cha (chi trong process con)
+    std::vector<record> batch_; // ban ghi dang ghi, chi dung khi giu drain_mutex_
+    uint64_t generation_ = 1; // tang trong process con sau fork: ring cu khong con dung
+    pthread_t thread_{};
+    bool running_ = false;
+    std::atomic<bool> stop_{false};
+
+    ring& local_ring() {
+        thread_local local_handle handle;
+        if (handle.r && handle.owner == this && handle.generation == generation_)
+            return handle.r->queue;
+        if (handle.r && handle.generation == generation_) // ring cua logger khac
+            handle.r->orphaned.store(true, std::memory_order_release);
+        check_result(pthread_mutex_lock(&registry_mutex_));
+        rings_.emplace_back(new thread_ring);
+        handle.r = rings_.back().get();
+        handle.owner = this;
+        handle.generation = generation_;
+        if (!running_) {
+            running_ = true;
+            stop_.store(false, std::memory_order_relaxed);
+            check_result(pthread_create(&thread_, nullptr, drain_thread, this));
+        }
+        check_result(pthread_mutex_unlock(&registry_mutex_));
+        return handle.r->queue;
+    }
+
+    static void* drain_thread(void* arg) {
+        auto* self = (async_logger*)arg;
+        while (!self->stop_.load(std::memory_order_relaxed)) {
+            check_result(pthread_mutex_lock(&self->drain_mutex_));
+            size_t n = self->drain();
+            check_result(pthread_mutex_unlock(&self->drain_mutex_));
+            if (n == 0)
+                usleep(IDLE_SLEEP_US); // nhan roi: gom them ban ghi cho dot sau
+        }
+        return nullptr;
+    }
+
+    // Goi khi dang giu drain_mutex_; tra ve so ban ghi da ghi
+    size_t drain() {
+        check_result(pthread_mutex_lock(&registry_mutex_));
+        std::vector<thread_ring*> snapshot;
+        snapshot.reserve(rings_.size());
+        for (auto& r : rings_)
+            snapshot.push_back(r.get());
+        check_result(pthread_mutex_unlock(&registry_mutex_));
+
+        iovec iov[BATCH];
+        size_t used = 0, total = 0;
+        bool orphans = false;
+        for (thread_ring* r : snapshot) {
+            orphans |= r->orphaned.load(std::memory_order_acquire);
+            bool more = false; // dang giua mot dong dai: cho phan con lai de dong khong bi xen
+            size_t n;
+            while ((n = more ? r->queue.dequeue_bulk(batch_.data() + used, BATCH - used)
+                             : r->queue.try_dequeue_bulk(batch_.data() + used, BATCH - used)) > 0) {
+                for (size_t i = used; i < used + n; ++i)
+                    iov[i] = {batch_[i].text, batch_[i].len};
+                used += n;
+                more = batch_[used - 1].more;
+                total += n;
+                if (used == BATCH) {
+                    write_all(iov, used);
+                    used = 0;
+                }
+            }
+        }
+        write_all(iov, used);
+        if (orphans)
+            remove_orphans();
+        return total;
+    }
+
+    // Ring cua thread da ket thuc va da rong thi khong bao gio co ban ghi moi
+    void remove_orphans() {
+        check_result(pthread_mutex_lock(&registry_mutex_));
+        rings_.erase(std::remove_if(rings_.begin(), rings_.end(), [](auto& r) {
+            return r->orphaned.load(std::memory_order_acquire) && r->queue.empty();
+        }), rings_.end());
+        check_result(pthread_mutex_unlock(&registry_mutex_));
+    }
+
+    // Loi ghi (vd stdout da dong) bi bo qua: log khong duoc lam hong chuong trinh
+    void write_all(iovec* iov, size_t count) {
+        while (count > 0) {
+            ssize_t written = writev(fd_, iov, (int)count);
+            if (written < 0) {
+                if (errno == EINTR)
+                    continue;
+                return;
+            }
+            while (count > 0 && (size_t)written >= iov->iov_len) {
+                written -= iov->iov_len;
+                ++iov;
+                --count;
+            }
+            if (count > 0) {
+                iov->iov_base = (char*)iov->iov_base + written;
+                iov->iov_len -= written;
+            }
+        }
+    }
+
+    // Fork: ghi het log cua cha va giu hai mutex de process con khong nhan mutex dang bi giu do
+    static void fork_prepare() {
+        async_logger& l = instance();
+        check_result(pthread_mutex_lock(&l.drain_mutex_));
+        while (l.drain() > 0) {}
+        check_result(pthread_mutex_lock(&l.registry_mutex_));
+    }
+
+    static void fork_parent() {
+        async_logger& l = instance();
+        check_result(pthread_mutex_unlock(&l.registry_mutex_));
+        check_result(pthread_mutex_unlock(&l.drain_mutex_));
+    }
+
+    // Process con chi co thread da goi fork: thread ghi va ring cua cac thread khac khong con
+    static void fork_child() {
+        async_logger& l = instance();
+        // chua giai phong: local_handle cua thread goi fork van tro vao ring cu cua no
+        for (auto& r : l.rings_)
+            l.retired_.push_back(std::move(r));
+        l.rings_.clear();
+        ++l.generation_;
+        l.running_ = false;
+        check_result(pthread_mutex_unlock(&l.registry_mutex_));
+        check_result(pthread_mutex_unlock(&l.drain_mutex_));
+    }
+};
+
+inline void log_async(std::string_view msg) {
+    async_logger::instance().log(msg);
+}
+
+#endif // ASYNC_LOG_HPP
@@ -0,0 +1,45 @@
+#ifndef ATOMIC_UTILS_HPP
+#define ATOMIC_UTILS_HPP
+
+#include <cstddef>
+#include <sched.h>
+
+// Kich thuoc cache line: bien duoc nhieu thread ghi dat cach nhau mot line de tranh false sharing
+constexpr size_t CACHE_LINE = 64;
+
+// Goi y cho CPU rang dang spin (pause tren x86, yield tren ARM)
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// Spin vai vong roi nhuong CPU; dung cho vong retry cua cac hang doi lock-free
+class backoff {
+    unsigned spins_ = 0;
+public:
+    static constexpr unsigned SPIN_LIMIT = 64;
+
+    void pause() {
+        if (spins_ < SPIN_LIMIT) {
+            for (unsigned i = 0; i <= spins_; ++i)
+                cpu_relax();
+            spins_ = spins_ ? spins_ * 2 : 1;
+        } else {
+            sched_yield();
+        }
+    }
+
+    void reset() { spins_ = 0; }
+};
+
+inline size_t round_up_pow2(size_t n) {
+    size_t p = 1;
+    while (p < n)
+        p <<= 1;
+    return p;
+}
+
+#endif // ATOMIC_UTILS_HPP
@@ -0,0 +1,170 @@
+#ifndef BROADCAST_RING_HPP
+#define BROADCAST_RING_HPP
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <cstdint>
+#include <iterator>
+#include <algorithm>
+#include <utility>
+#include "atomic_utils.hpp"
+#include "wait_policy.hpp"
+
+// Ring kieu Disruptor: mot producer, moi phan tu duoc MOI consumer doc (khong phai chia cho
+// mot consumer nhu mt_queue). Phan tu nam mot lan trong ring, moi consumer co cursor rieng;
+// producer chi ghi de o khi consumer cham nhat da doc qua. Consumer xu ly ca dot phan tu
+// truc tiep trong ring roi moi day cursor mot lan, producer nho min cursor va chi quet lai
+// khi tuong la day. Dung luong lam tron len luy thua cua 2; T phai default-constructible.
+template <typename T, typename Wait = spin_futex_wait<>>
+class broadcast_ring {
+    struct alignas(CACHE_LINE) cursor {
+        std::atomic<uint64_t> next{0};     // phan tu tiep theo consumer se doc
+        std::atomic<bool> attached{true}; // consumer da detach thi khong con chan producer
+    };
+
+    std::unique_ptr<T[]> buffer_;
+    size_t mask_;
+    std::unique_ptr<cursor[]> cursors_;
+    size_t consumers_;
+    alignas(CACHE_LINE) std::atomic<uint64_t> published_{0}; // so phan tu da cong bo
+    alignas(CACHE_LINE) uint64_t next_ = 0;  // chi producer dung
+    uint64_t gate_ = 0;                      // min cursor lan quet truoc, chi producer dung
+    std::atomic<bool> closed_{false};
+    typename Wait::waiter not_empty_, not_full_;
+
+public:
+    broadcast_ring(size_t max_size, size_t consumers)
+        : buffer_(new T[round_up_pow2(max_size < 2 ? 2 : max_size)]),
+          mask_(round_up_pow2(max_size < 2 ? 2 : max_size) - 1),
+          cursors_(new cursor[consumers]), consumers_(consumers) {}
+
+    broadcast_ring(const broadcast_ring&) = delete;
+    broadcast_ring(broadcast_ring&&) = delete;
+
+    size_t capacity() const { return mask_ + 1; }
+    size_t consumers() const { return consumers_; }
+
+    // ---- producer (chi mot thread) ----
+
+    bool try_publish(const T& v) { return try_publish_bulk(&v, &v + 1) == 1; }
+
+    bool try_publish(T&& v) { return try_publish_bulk(std::make_move_iterator(&v), std::make_move_iterator(&v + 1)) == 1; }
+
+    // Ghi nhieu phan tu nhat co the con cho, cong bo ca dot bang mot lan store
+    template <typename It>
+    size_t try_publish_bulk(It first, It last) {
+        size_t want = std::distance(first, last);
+        if (want == 0 || closed_.load(std::memory_order_relaxed))
+            return 0;
+        if (next_ - gate_ + want > capacity())
+            gate_ = min_cursor();
+        size_t n = std::min<size_t>(want, capacity() - (next_ - gate_));
+        if (n == 0)
+            return 0;
+        for (size_t i = 0; i < n; ++i, ++first)
+            buffer_[(next_ + i) & mask_] = *first;
+        next_ += n;
+        published_.store(next_, std::memory_order_release);
+        not_empty_.notify_all(); // moi consumer deu can thay
+        return n;
+    }
+
+    // Tra ve false neu ring da dong
+    bool publish(const T& v) { return publish_bulk(&v, &v + 1) == 1; }
+
+    bool publish(T&& v) { return publish_bulk(std::make_move_iterator(&v), std::make_move_iterator(&v + 1)) == 1; }
+
+    template <typename It>
+    size_t publish_bulk(It first, It last) {
+        size_t total = 0;
+        while (first != last && !closed_.load(std::memory_order_acquire)) {
+            size_t n = try_publish_bulk(first, last);
+            std::advance(first, n);
+            total += n;
+            if (n == 0)
+                not_full_.wait([this] { return writable() || closed(); });
+        }
+        return total;
+    }
+
+    // Consumer doc het phan tu con lai roi nhan 0
+    void close() {
+        closed_.store(true, std::memory_order_release);
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+    bool closed() const {
+        return closed_.load(std::memory_order_acquire);
+    }
+
+    // ---- consumer id (0..consumers-1, moi id mot thread) ----
+
+    // Goi f(const T&) cho toi da max phan tu chua doc roi day cursor mot lan; tra ve so phan tu.
+    // f chay khi o con thuoc consumer: khong chep phan tu, nhung producer co the phai cho f.
+    template <typename F>
+    size_t try_consume(size_t id, F&& f, size_t max = SIZE_MAX) {
+        cursor& c = cursors_[id];
+        uint64_t next = c.next.load(std::memory_order_relaxed);
+        size_t n = std::min<uint64_t>(published_.load(std::memory_order_acquire) - next, max);
+        if (n == 0)
+            return 0;
+        for (size_t i = 0; i < n; ++i)
+            f(std::as_const(buffer_[(next + i) & mask_]));
+        c.next.store(next + n, std::memory_order_release);
+        not_full_.notify_one(); // chi producer cho
+        return n;
+    }
+
+    // Cho den khi co phan tu; 0 khi ring da dong va consumer da doc het
+    template <typename F>
+    size_t consume(size_t id, F&& f, size_t max = SIZE_MAX) {
+        size_t n;
+        while ((n = try_consume(id, f, max)) == 0) {
+            if (closed_.load(std::memory_order_acquire))
+                return try_consume(id, f, max);
+            not_empty_.wait([this, id] { return readable(id) || closed(); });
+        }
+        return n;
+    }
+
+    // Tien loi: chep mot phan tu
+    std::optional<T> receive(size_t id) {
+        std::optional<T> v;
+        consume(id, [&v](const T& x) { v.emplace(x); }, 1);
+        return v;
+    }
+
+    // Consumer ngung doc: producer khong cho consumer nay nua
+    void detach(size_t id) {
+        cursors_[id].attached.store(false, std::memory_order_seq_cst);
+        not_full_.notify_one();
+    }
+
+    // Chi la anh chup
+    size_t backlog(size_t id) const {
+        return published_.load(std::memory_order_relaxed) - cursors_[id].next.load(std::memory_order_relaxed);
+    }
+
+private:
+    // Consumer cham nhat; khong con consumer nao thi ca ring deu trong
+    uint64_t min_cursor() const {
+        uint64_t m = next_;
+        for (size_t i = 0; i < consumers_; ++i)
+            if (cursors_[i].attached.load(std::memory_order_seq_cst))
+                m = std::min(m, cursors_[i].next.load(std::memory_order_seq_cst));
+        return m;
+    }
+
+    // Dieu kien cho: doc seq_cst de cap voi fence trong Wait::waiter::notify
+    bool writable() const {
+        return next_ - min_cursor() < capacity();
+    }
+
+    bool readable(size_t id) const {
+        return published_.load(std::memory_order_seq_cst) > cursors_[id].next.load(std::memory_order_relaxed);
+    }
+};
+
+#endif // BROADCAST_RING_HPP
@@ -0,0 +1,117 @@
+#ifndef CHASE_LEV_DEQUE_HPP
+#define CHASE_LEV_DEQUE_HPP
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+#include "atomic_utils.hpp"
+
+// Deque work-stealing Chase-Lev, theo ban C11 cua Le, Pop, Cohen, Zappa Nardelli (PPoPP 2013).
+// Chi thread chu (owner) duoc goi push/pop: day va lay o dau bottom (LIFO, khong khoa,
+// chi co CAS khi tranh phan tu cuoi cung voi thief). Thread khac goi steal: lay o dau top (FIFO)
+// bang mot CAS. Mang tu lon gap doi khi day; mang cu duoc giu den khi huy deque
+// vi thief co the van dang doc no.
+// T thuong la con tro toi task nen phai trivially copyable (doc/ghi bang atomic).
+template <typename T>
+class chase_lev_deque {
+    static_assert(std::is_trivially_copyable<T>::value, "chase_lev_deque can T trivially copyable");
+
+    struct array {
+        int64_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+
+        explicit array(int64_t capacity) : mask(capacity - 1), slots(new std::atomic<T>[capacity]) {}
+
+        int64_t capacity() const { return mask + 1; }
+        T get(int64_t i) const { return slots[i & mask].load(std::memory_order_relaxed); }
+        void put(int64_t i, T v) { slots[i & mask].store(v, std::memory_order_relaxed); }
+    };
+
+    alignas(CACHE_LINE) std::atomic<int64_t> top_{0};    // thief tang bang CAS
+    alignas(CACHE_LINE) std::atomic<int64_t> bottom_{0}; // chi owner ghi
+    std::atomic<array*> array_;
+    std::vector<std::unique_ptr<array>> arrays_; // moi mang tung cap phat, owner quan ly
+
+public:
+    explicit chase_lev_deque(size_t capacity = 64) {
+        arrays_.emplace_back(new array((int64_t)round_up_pow2(capacity < 2 ? 2 : capacity)));
+        array_.store(arrays_.back().get(), std::memory_order_relaxed);
+    }
+
+    chase_lev_deque(const chase_lev_deque&) = delete;
+    chase_lev_deque(chase_lev_deque&&) = delete;
+
+    // Chi owner
+    void push(T v) {
+        int64_t b = bottom_.load(std::memory_order_relaxed);
+        int64_t t = top_.load(std::memory_order_acquire);
+        array* a = array_.load(std::memory_order_relaxed);
+        if (b - t > a->mask)
+            a = grow(a, t, b);
+        a->put(b, v);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // Chi owner; lay phan tu moi day vao nhat
+    std::optional<T> pop() {
+        int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        array* a = array_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top_.load(std::memory_order_relaxed);
+        if (t > b) { // rong
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+        T v = a->get(b);
+        if (t == b) { // phan tu cuoi: tranh voi thief
+            bool won = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                    std::memory_order_relaxed);
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            if (!won)
+                return std::nullopt;
+        }
+        return v;
+    }
+
+    // Thread bat ky; lay phan tu cu nhat. nullopt khi rong hoac thua CAS voi thread khac
+    // (goi lai hoac sang deque khac)
+    std::optional<T> steal() {
+        int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b)
+            return std::nullopt;
+        array* a = array_.load(std::memory_order_acquire);
+        T v = a->get(t);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed))
+            return std::nullopt;
+        return v;
+    }
+
+    // Chi la anh chup
+    size_t size() const {
+        int64_t b = bottom_.load(std::memory_order_relaxed);
+        int64_t t = top_.load(std::memory_order_relaxed);
+        return b > t ? (size_t)(b - t) : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+
+private:
+    array* grow(array* old, int64_t t, int64_t b) {
+        arrays_.emplace_back(new array(old->capacity() * 2));
+        array* a = arrays_.back().get();
+        for (int64_t i = t; i < b; ++i)
+            a->put(i, old->get(i));
+        array_.store(a, std::memory_order_release);
+        return a;
+    }
+};
+
+#endif // CHASE_LEV_DEQUE_HPP
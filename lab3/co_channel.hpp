@@ -0,0 +1,258 @@
+#ifndef CO_CHANNEL_HPP
+#define CO_CHANNEL_HPP
+
+#include <coroutine>
+#include <optional>
+#include <deque>
+#include <vector>
+#include <atomic>
+#include <utility>
+#include <exception>
+#include <pthread.h>
+#include "check.hpp"
+#include "mt_queue.hpp"
+
+// Kenh cho coroutine C++20: co_await ch.pop() / co_await ch.push(v) treo coroutine (khong treo
+// thread) khi kenh rong/day, coroutine duoc dua lai vao executor khi co du lieu/cho trong.
+// Ngu nghia giong mt_queue: push tra ve false khi kenh da dong, pop tra ve nullopt khi
+// kenh da dong va da lay het. Hang nghin coroutine chay tren vai thread cua executor.
+
+class executor;
+
+// Coroutine chay doc lap (fire-and-forget), bat dau khi executor::spawn
+class co_task {
+public:
+    struct promise_type {
+        executor* exec = nullptr;
+
+        co_task get_return_object() {
+            return co_task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; } // frame tu huy
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+        ~promise_type();
+    };
+
+    co_task(co_task&& o) noexcept : h_(std::exchange(o.h_, {})) {}
+    co_task(const co_task&) = delete;
+
+    ~co_task() {
+        if (h_)
+            h_.destroy(); // chua duoc spawn
+    }
+
+private:
+    friend class executor;
+    explicit co_task(std::coroutine_handle<promise_type> h) : h_(h) {}
+    std::coroutine_handle<promise_type> h_;
+};
+
+// Nhom thread lay coroutine san sang tu mt_queue va resume. Moi co_task song nam trong hang doi
+// toi da mot lan (chi coroutine dang treo moi duoc schedule), nen spawn gioi han so co_task song
+// o max_tasks = dung luong hang doi: schedule tu thread cua executor khong bao gio bi chan.
+class executor {
+    mt_queue<std::coroutine_handle<>> ready_;
+    std::vector<pthread_t> threads_;
+    size_t max_tasks_;
+    std::atomic<size_t> live_{0}; // so co_task da spawn chua ket thuc
+    pthread_mutex_t idle_mutex_;
+    pthread_cond_t idle_;
+
+    static void* worker(void* arg) {
+        auto* self = (executor*)arg;
+        while (auto h = self->ready_.dequeue())
+            h->resume();
+        return nullptr;
+    }
+
+public:
+    explicit executor(unsigned threads, size_t max_tasks = 1 << 16) : ready_(max_tasks), max_tasks_(max_tasks) {
+        pthread_mutex_init(&idle_mutex_, nullptr);
+        pthread_cond_init(&idle_, nullptr);
+        threads_.resize(threads ? threads : 1);
+        for (pthread_t& t : threads_)
+            check_result(pthread_create(&t, nullptr, worker, this));
+    }
+
+    executor(const executor&) = delete;
+
+    ~executor() {
+        ready_.close();
+        for (pthread_t t : threads_)
+            pthread_join(t, nullptr);
+        pthread_mutex_destroy(&idle_mutex_);
+        pthread_cond_destroy(&idle_);
+    }
+
+    void schedule(std::coroutine_handle<> h) {
+        ready_.enqueue(h);
+    }
+
+    // false (task bi huy, khong chay) khi da co max_tasks co_task dang song
+    [[nodiscard]] bool spawn(co_task t) {
+        size_t live = live_.load(std::memory_order_relaxed);
+        do {
+            if (live >= max_tasks_)
+                return false;
+        } while (!live_.compare_exchange_weak(live, live + 1, std::memory_order_relaxed));
+        t.h_.promise().exec = this;
+        schedule(std::exchange(t.h_, {}));
+        return true;
+    }
+
+    // Cho den khi moi co_task da spawn ket thuc
+    void wait() {
+        check_result(pthread_mutex_lock(&idle_mutex_));
+        while (live_.load(std::memory_order_acquire) > 0)
+            check_result(pthread_cond_wait(&idle_, &idle_mutex_));
+        check_result(pthread_mutex_unlock(&idle_mutex_));
+    }
+
+    // co_await exec.yield(): nhuong thread cho coroutine khac
+    auto yield() {
+        struct awaiter {
+            executor* exec;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> h) { exec->schedule(h); }
+            void await_resume() const noexcept {}
+        };
+        return awaiter{this};
+    }
+
+private:
+    friend struct co_task::promise_type;
+
+    void task_done() {
+        if (live_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            check_result(pthread_mutex_lock(&idle_mutex_));
+            check_result(pthread_cond_broadcast(&idle_));
+            check_result(pthread_mutex_unlock(&idle_mutex_));
+        }
+    }
+};
+
+inline co_task::promise_type::~promise_type() {
+    if (exec)
+        exec->task_done();
+}
+
+template <typename T>
+class co_channel {
+    struct push_awaiter;
+    struct pop_awaiter;
+
+    executor& exec_;
+    size_t max_size_;
+    std::deque<T> buffer_;
+    std::deque<push_awaiter*> senders_;   // coroutine dang cho cho trong
+    std::deque<pop_awaiter*> receivers_;  // coroutine dang cho du lieu
+    bool closed_ = false;
+    pthread_mutex_t mutex_;
+
+    // Sau khi dua awaiter vao hang cho va mo khoa, coroutine co the duoc resume ngay o thread khac:
+    // await_suspend khong duoc dung toi awaiter nua.
+    struct push_awaiter {
+        co_channel* ch;
+        T value;
+        bool ok = true;
+        std::coroutine_handle<> handle{};
+
+        bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(std::coroutine_handle<> h) {
+            check_result(pthread_mutex_lock(&ch->mutex_));
+            if (ch->closed_) {
+                ok = false;
+            } else if (!ch->receivers_.empty()) { // trao thang cho coroutine dang cho
+                pop_awaiter* r = ch->receivers_.front();
+                ch->receivers_.pop_front();
+                r->value.emplace(std::move(value));
+                ch->exec_.schedule(r->handle);
+            } else if (ch->buffer_.size() < ch->max_size_) {
+                ch->buffer_.push_back(std::move(value));
+            } else {
+                handle = h;
+                ch->senders_.push_back(this);
+                check_result(pthread_mutex_unlock(&ch->mutex_));
+                return true;
+            }
+            check_result(pthread_mutex_unlock(&ch->mutex_));
+            return false; // khong treo
+        }
+
+        bool await_resume() const noexcept { return ok; }
+    };
+
+    struct pop_awaiter {
+        co_channel* ch;
+        std::optional<T> value;
+        std::coroutine_handle<> handle{};
+
+        bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(std::coroutine_handle<> h) {
+            check_result(pthread_mutex_lock(&ch->mutex_));
+            if (!ch->buffer_.empty()) {
+                value.emplace(std::move(ch->buffer_.front()));
+                ch->buffer_.pop_front();
+                if (!ch->senders_.empty()) { // cho vua trong: nhan phan tu cua sender dang cho
+                    push_awaiter* s = ch->senders_.front();
+                    ch->senders_.pop_front();
+                    ch->buffer_.push_back(std::move(s->value));
+                    ch->exec_.schedule(s->handle);
+                }
+            } else if (!ch->senders_.empty()) { // dung luong 0: nhan thang tu sender
+                push_awaiter* s = ch->senders_.front();
+                ch->senders_.pop_front();
+                value.emplace(std::move(s->value));
+                ch->exec_.schedule(s->handle);
+            } else if (!ch->closed_) {
+                handle = h;
+                ch->receivers_.push_back(this);
+                check_result(pthread_mutex_unlock(&ch->mutex_));
+                return true;
+            }
+            check_result(pthread_mutex_unlock(&ch->mutex_));
+            return false;
+        }
+
+        std::optional<T> await_resume() { return std::move(value); }
+    };
+
+public:
+    // max_size = 0: kenh dong bo, push cho den khi co coroutine pop
+    co_channel(executor& exec, size_t max_size) : exec_(exec), max_size_(max_size) {
+        pthread_mutex_init(&mutex_, nullptr);
+    }
+
+    co_channel(const co_channel&) = delete;
+
+    ~co_channel() {
+        pthread_mutex_destroy(&mutex_);
+    }
+
+    // co_await ch.push(v) -> false neu kenh da dong
+    push_awaiter push(T v) { return push_awaiter{this, std::move(v)}; }
+
+    // co_await ch.pop() -> nullopt khi kenh da dong va rong
+    pop_awaiter pop() { return pop_awaiter{this, std::nullopt}; }
+
+    // Coroutine dang cho pop nhan nullopt, dang cho push nhan false
+    void close() {
+        check_result(pthread_mutex_lock(&mutex_));
+        closed_ = true;
+        for (pop_awaiter* r : receivers_)
+            exec_.schedule(r->handle);
+        for (push_awaiter* s : senders_) {
+            s->ok = false;
+            exec_.schedule(s->handle);
+        }
+        receivers_.clear();
+        senders_.clear();
+        check_result(pthread_mutex_unlock(&mutex_));
+    }
+};
+
+#endif // CO_CHANNEL_HPP
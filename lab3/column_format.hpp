@@ -0,0 +1,115 @@
+#ifndef COLUMN_FORMAT_HPP
+#define COLUMN_FORMAT_HPP
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "check.hpp"
+
+// Cot du lieu co kieu: ColumnFileHeader | T[element_count].
+// File khong co header van doc duoc, kieu khi do lay tu tham so dong lenh (mac dinh int32).
+constexpr uint32_t COLUMN_MAGIC = 0x544c4f43; // "COLT"
+
+enum class ElementType : uint32_t { Int8, Int16, Int32, Int64, Float, Double };
+
+struct ColumnFileHeader {
+    uint32_t magic;
+    ElementType type;
+    uint64_t element_count;
+};
+
+template <typename T> constexpr ElementType element_type_of();
+template <> constexpr ElementType element_type_of<int8_t>() { return ElementType::Int8; }
+template <> constexpr ElementType element_type_of<int16_t>() { return ElementType::Int16; }
+template <> constexpr ElementType element_type_of<int32_t>() { return ElementType::Int32; }
+template <> constexpr ElementType element_type_of<int64_t>() { return ElementType::Int64; }
+template <> constexpr ElementType element_type_of<float>() { return ElementType::Float; }
+template <> constexpr ElementType element_type_of<double>() { return ElementType::Double; }
+
+inline const char* element_type_name(ElementType t) {
+    switch (t) {
+        case ElementType::Int8: return "int8";
+        case ElementType::Int16: return "int16";
+        case ElementType::Int32: return "int32";
+        case ElementType::Int64: return "int64";
+        case ElementType::Float: return "float";
+        case ElementType::Double: return "double";
+    }
+    return "?";
+}
+
+inline bool parse_element_type(const std::string& name, ElementType& t) {
+    for (ElementType e : {ElementType::Int8, ElementType::Int16, ElementType::Int32,
+                          ElementType::Int64, ElementType::Float, ElementType::Double}) {
+        if (name == element_type_name(e)) {
+            t = e;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Goi f(T{}) voi T tuong ung voi kieu luc chay
+template <typename F>
+decltype(auto) dispatch_element_type(ElementType t, F&& f) {
+    switch (t) {
+        case ElementType::Int8: return f(int8_t{});
+        case ElementType::Int16: return f(int16_t{});
+        case ElementType::Int64: return f(int64_t{});
+        case ElementType::Float: return f(float{});
+        case ElementType::Double: return f(double{});
+        default: return f(int32_t{});
+    }
+}
+
+// Doc/ghi het count byte (read/write co the tra ve it hon yeu cau voi file lon)
+inline void pread_all(int fd, void* buf, size_t count, off_t offset) {
+    size_t done = 0;
+    while (done < count) {
+        ssize_t r = check(pread(fd, (char*)buf + done, count - done, offset + done));
+        if (r == 0)
+            break;
+        done += r;
+    }
+}
+
+inline void pwrite_all(int fd, const void* buf, size_t count, off_t offset) {
+    size_t done = 0;
+    while (done < count)
+        done += check(pwrite(fd, (const char*)buf + done, count - done, offset + done));
+}
+
+// Nhu pwrite_all nhung tra ve false (errno giu loi) thay vi thoat: cho file khong bat buoc nhu cache
+inline bool try_pwrite_all(int fd, const void* buf, size_t count, off_t offset) {
+    size_t done = 0;
+    while (done < count) {
+        ssize_t n = pwrite(fd, (const char*)buf + done, count - done, offset + done);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        done += n;
+    }
+    return true;
+}
+
+// Tra ve true va dien header neu file co header cot
+inline bool read_column_header(int fd, ColumnFileHeader& h) {
+    return pread(fd, &h, sizeof(h), 0) == (ssize_t)sizeof(h) && h.magic == COLUMN_MAGIC;
+}
+
+template <typename T>
+void write_column_file(const std::string& path, const T* data, size_t n) {
+    int fd = check(open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644));
+    ColumnFileHeader h{COLUMN_MAGIC, element_type_of<T>(), n};
+    pwrite_all(fd, &h, sizeof(h), 0);
+    pwrite_all(fd, data, n * sizeof(T), sizeof(h));
+    check(close(fd));
+}
+
+#endif // COLUMN_FORMAT_HPP
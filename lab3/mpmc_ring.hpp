@@ -0,0 +1,267 @@
+#ifndef MPMC_RING_HPP
+#define MPMC_RING_HPP
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include "atomic_utils.hpp"
+#include "wait_policy.hpp"
+
+// Hang doi vong bounded MPMC khong khoa (Dmitry Vyukov): moi o co sequence number cho biet
+// o dang trong hay da co du lieu o vong (lap) nao, nen producer/consumer chi can mot CAS
+// tren vi tri cua minh. Cung bo ham voi mt_queue; dung luong lam tron len luy thua cua 2.
+// Ham blocking cho qua Wait (mac dinh spin roi futex), notify sau moi lan cong bo o.
+template <typename T, typename Wait = spin_futex_wait<>>
+class mpmc_ring {
+    struct cell {
+        std::atomic<size_t> seq;
+        T value;
+    };
+
+    std::unique_ptr<cell[]> buffer_;
+    size_t mask_;
+    alignas(CACHE_LINE) std::atomic<size_t> enqueue_pos_{0};
+    alignas(CACHE_LINE) std::atomic<size_t> dequeue_pos_{0};
+    std::atomic<bool> closed_{false};
+    typename Wait::waiter not_empty_, not_full_;
+
+public:
+    explicit mpmc_ring(size_t max_size)
+        : buffer_(new cell[round_up_pow2(max_size < 2 ? 2 : max_size)]),
+          mask_(round_up_pow2(max_size < 2 ? 2 : max_size) - 1) {
+        for (size_t i = 0; i <= mask_; ++i)
+            buffer_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    mpmc_ring(const mpmc_ring&) = delete;
+    mpmc_ring(mpmc_ring&&) = delete;
+
+    size_t capacity() const { return mask_ + 1; }
+
+    bool try_enqueue(const T& v) { return try_put(v); }
+    bool try_enqueue(T&& v) { return try_put(std::move(v)); }
+
+    // O da duoc tao san nen phan tu duoc tao mot lan roi chuyen vao o
+    template <typename... Args>
+    bool try_emplace(Args&&... args) {
+        return try_put(T(std::forward<Args>(args)...));
+    }
+
+    std::optional<T> try_dequeue() {
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        cell* c;
+        while (true) {
+            c = &buffer_[pos & mask_];
+            size_t seq = c->seq.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (dif == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (dif < 0) { // rong
+                return std::nullopt;
+            } else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        std::optional<T> val(std::move(c->value));
+        c->seq.store(pos + mask_ + 1, std::memory_order_release); // giai phong o cho vong sau
+        not_full_.notify_one();
+        return val;
+    }
+
+    // Gianh ca dot o lien tiep bang mot CAS tren enqueue_pos_; tra ve so phan tu da day
+    template <typename It>
+    size_t try_enqueue_bulk(It first, It last) {
+        size_t want = std::distance(first, last);
+        if (want == 0 || closed_.load(std::memory_order_relaxed))
+            return 0;
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        size_t n;
+        while (true) {
+            n = 0;
+            while (n < want && n <= mask_
+                   && buffer_[(pos + n) & mask_].seq.load(std::memory_order_acquire) == pos + n)
+                ++n;
+            if (n > 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed))
+                    break;
+                continue;
+            }
+            size_t seq = buffer_[pos & mask_].seq.load(std::memory_order_acquire);
+            if ((intptr_t)seq - (intptr_t)pos < 0)
+                return 0; // day
+            pos = enqueue_pos_.load(std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < n; ++i, ++first) {
+            cell& c = buffer_[(pos + i) & mask_];
+            c.value = *first;
+            c.seq.store(pos + i + 1, std::memory_order_release);
+        }
+        wake(not_empty_, n);
+        return n;
+    }
+
+    template <typename OutIt>
+    size_t try_dequeue_bulk(OutIt out, size_t max) {
+        if (max == 0)
+            return 0;
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        size_t n;
+        while (true) {
+            n = 0;
+            while (n < max && n <= mask_
+                   && buffer_[(pos + n) & mask_].seq.load(std::memory_order_acquire) == pos + n + 1)
+                ++n;
+            if (n > 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed))
+                    break;
+                continue;
+            }
+            size_t seq = buffer_[pos & mask_].seq.load(std::memory_order_acquire);
+            if ((intptr_t)seq - (intptr_t)(pos + 1) < 0)
+                return 0; // rong
+            pos = dequeue_pos_.load(std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < n; ++i) {
+            cell& c = buffer_[(pos + i) & mask_];
+            *out++ = std::move(c.value);
+            c.seq.store(pos + i + mask_ + 1, std::memory_order_release);
+        }
+        wake(not_full_, n);
+        return n;
+    }
+
+    template <typename It>
+    size_t enqueue_bulk(It first, It last) {
+        size_t total = 0;
+        while (first != last && !closed_.load(std::memory_order_acquire)) {
+            size_t n = try_enqueue_bulk(first, last);
+            std::advance(first, n);
+            total += n;
+            if (n == 0)
+                not_full_.wait([this] { return writable() || closed(); });
+        }
+        return total;
+    }
+
+    template <typename OutIt>
+    size_t dequeue_bulk(OutIt out, size_t max) {
+        if (max == 0)
+            return 0;
+        size_t n;
+        while ((n = try_dequeue_bulk(out, max)) == 0) {
+            if (closed_.load(std::memory_order_acquire))
+                return try_dequeue_bulk(out, max);
+            not_empty_.wait([this] { return readable() || closed(); });
+        }
+        return n;
+    }
+
+    // Tra ve false neu hang doi da dong
+    bool enqueue(const T& v) { return put(v); }
+    bool enqueue(T&& v) { return put(std::move(v)); }
+
+    template <typename... Args>
+    bool emplace(Args&&... args) {
+        return put(T(std::forward<Args>(args)...));
+    }
+
+    // nullopt khi hang doi da dong va rong
+    std::optional<T> dequeue() {
+        while (true) {
+            if (auto v = try_dequeue())
+                return v;
+            if (closed_.load(std::memory_order_acquire))
+                return try_dequeue();
+            not_empty_.wait([this] { return readable() || closed(); });
+        }
+    }
+
+    void close() {
+        closed_.store(true, std::memory_order_release);
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+    bool closed() const {
+        return closed_.load(std::memory_order_acquire);
+    }
+
+    // Chi la anh chup: co the da thay doi ngay khi tra ve
+    bool full() const {
+        return enqueue_pos_.load(std::memory_order_relaxed) - dequeue_pos_.load(std::memory_order_relaxed) > mask_;
+    }
+
+    bool empty() const {
+        return enqueue_pos_.load(std::memory_order_relaxed) == dequeue_pos_.load(std::memory_order_relaxed);
+    }
+
+private:
+    template <typename U>
+    bool put(U&& v) {
+        while (!try_put(std::forward<U>(v))) { // chi bi chuyen di khi thanh cong
+            if (closed_.load(std::memory_order_acquire))
+                return false;
+            not_full_.wait([this] { return writable() || closed(); });
+        }
+        return true;
+    }
+
+    template <typename U>
+    bool try_put(U&& v) {
+        if (closed_.load(std::memory_order_relaxed))
+            return false;
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        cell* c;
+        while (true) {
+            c = &buffer_[pos & mask_];
+            size_t seq = c->seq.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+            if (dif == 0) { // o trong cho vong nay: gianh lay vi tri
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (dif < 0) { // o van chua du lieu cua vong truoc: day
+                return false;
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        c->value = std::forward<U>(v);
+        c->seq.store(pos + 1, std::memory_order_release);
+        not_empty_.notify_one();
+        return true;
+    }
+
+    // O tiep theo cua consumer da co du lieu / o tiep theo cua producer da trong.
+    // Dung lam dieu kien cho thay vi full()/empty(): vi tri da gianh nhung chua cong bo
+    // thi chua dang de thuc day. Neu o da bi thread khac lay mat thi doc lai vi tri.
+    bool readable() const {
+        while (true) {
+            size_t pos = dequeue_pos_.load(std::memory_order_seq_cst);
+            intptr_t dif = (intptr_t)buffer_[pos & mask_].seq.load(std::memory_order_seq_cst) - (intptr_t)(pos + 1);
+            if (dif <= 0)
+                return dif == 0;
+        }
+    }
+
+    bool writable() const {
+        while (true) {
+            size_t pos = enqueue_pos_.load(std::memory_order_seq_cst);
+            intptr_t dif = (intptr_t)buffer_[pos & mask_].seq.load(std::memory_order_seq_cst) - (intptr_t)pos;
+            if (dif <= 0)
+                return dif == 0;
+        }
+    }
+
+    void wake(typename Wait::waiter& w, size_t n) {
+        if (n == 1)
+            w.notify_one();
+        else if (n > 1)
+            w.notify_all();
+    }
+};
+
+#endif // MPMC_RING_HPP
@@ -0,0 +1,262 @@
+#ifndef MPSC_QUEUE_HPP
+#define MPSC_QUEUE_HPP
+
+#include <atomic>
+#include <optional>
+#include <new>
+#include <cstdint>
+#include <utility>
+#include <sched.h>
+#include "atomic_utils.hpp"
+#include "wait_policy.hpp"
+
+// Hang doi MPSC khong gioi han kieu Dmitry Vyukov: nhieu producer, mot consumer.
+// Producer chi can mot atomic exchange tren head_ (khong CAS, khong vong lap), consumer
+// doc tu tail_ khong dung atomic RMW nao. Nut nam ngay trong phan tu (intrusive).
+//
+// Giua exchange va lien ket nut cu (prev->next) cua mot producer, nut moi chua nhin thay
+// tu tail: pop() tra ve nullptr du hang doi khong rong, producer do se lien ket ngay sau.
+
+struct mpsc_node {
+    std::atomic<mpsc_node*> next{nullptr};
+};
+
+class intrusive_mpsc_queue {
+    alignas(CACHE_LINE) std::atomic<mpsc_node*> head_; // producer ghi
+    alignas(CACHE_LINE) mpsc_node* tail_;              // chi consumer
+    mpsc_node stub_;                                   // nut gia: hang doi khong bao gio rong nut
+
+public:
+    intrusive_mpsc_queue() : head_(&stub_), tail_(&stub_) {}
+
+    intrusive_mpsc_queue(const intrusive_mpsc_queue&) = delete;
+
+    // Goi tu bat ky thread nao; n khong duoc dang nam trong hang doi
+    void push(mpsc_node* n) {
+        n->next.store(nullptr, std::memory_order_relaxed);
+        mpsc_node* prev = head_.exchange(n, std::memory_order_acq_rel);
+        prev->next.store(n, std::memory_order_release);
+    }
+
+    // Chi consumer; nullptr khi rong (hoac producer dang giua push)
+    mpsc_node* pop() {
+        mpsc_node* tail = tail_;
+        mpsc_node* next = tail->next.load(std::memory_order_acquire);
+        if (tail == &stub_) {
+            if (!next)
+                return nullptr;
+            tail_ = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next) {
+            tail_ = next;
+            return tail;
+        }
+        if (tail != head_.load(std::memory_order_acquire))
+            return nullptr; // nut sau tail da duoc exchange nhung chua lien ket
+        push(&stub_);       // tail la nut cuoi: chen stub de lay duoc tail
+        next = tail->next.load(std::memory_order_acquire);
+        if (next) {
+            tail_ = next;
+            return tail;
+        }
+        return nullptr;
+    }
+
+    // Chi consumer; anh chup
+    bool empty() const {
+        return tail_ == &stub_ && stub_.next.load(std::memory_order_acquire) == nullptr;
+    }
+};
+
+// Hang doi gia tri tren intrusive_mpsc_queue. Nut lay tu pool cua thread producer: danh sach
+// rong cuc bo (khong dong bo) va mot stack atomic ma consumer tra nut ve. Khi het nut cuc bo,
+// producer lay ca stack bang mot exchange; chi cap phat moi khi ca hai deu rong.
+// Pool song den khi thread ket thuc va moi nut cua no da duoc tra/giai phong.
+template <typename T, typename Wait = spin_futex_wait<>>
+class mpsc_queue {
+    struct node_pool;
+
+    struct node : mpsc_node {
+        node_pool* owner;
+        alignas(T) unsigned char bytes[sizeof(T)];
+
+        T* value() { return std::launder(reinterpret_cast<T*>(bytes)); }
+    };
+
+    struct node_pool {
+        node* local = nullptr;              // chi thread so huu
+        std::atomic<node*> remote{nullptr}; // nut thread khac tra ve; closed() khi thread so huu da ket thuc
+        std::atomic<size_t> refs{1};        // so nut con ton tai + 1 cho thread so huu
+
+        static node* closed() { return reinterpret_cast<node*>(uintptr_t(1)); }
+
+        static node* next_free(node* n) {
+            return static_cast<node*>(n->next.load(std::memory_order_relaxed));
+        }
+
+        node* acquire() {
+            node* n = local;
+            if (!n)
+                n = remote.exchange(nullptr, std::memory_order_acquire);
+            if (n) {
+                local = next_free(n);
+                return n;
+            }
+            refs.fetch_add(1, std::memory_order_relaxed);
+            n = new node;
+            n->owner = this;
+            return n;
+        }
+
+        // Goi tu consumer (thread bat ky). Sau khi day nut vao remote khong duoc dung toi pool nua:
+        // thread so huu co the giai phong pool ngay sau do
+        void give_back(node* n) {
+            node* top = remote.load(std::memory_order_relaxed);
+            do {
+                if (top == closed()) { // khong con ai lay lai nut: giai phong luon
+                    delete n;
+                    unref(1);
+                    return;
+                }
+                n->next.store(top, std::memory_order_relaxed);
+            } while (!remote.compare_exchange_weak(top, n, std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        static size_t free_list(node* n) {
+            size_t freed = 0;
+            for (; n; ++freed) {
+                node* next = next_free(n);
+                delete n;
+                n = next;
+            }
+            return freed;
+        }
+
+        void unref(size_t n) {
+            if (refs.fetch_sub(n, std::memory_order_acq_rel) == n)
+                delete this;
+        }
+
+        // Thread so huu ket thuc: nut dang nam trong hang doi duoc giai phong khi consumer tra ve
+        void orphan() {
+            size_t freed = free_list(local);
+            local = nullptr;
+            freed += free_list(remote.exchange(closed(), std::memory_order_acquire));
+            unref(freed + 1);
+        }
+    };
+
+    struct pool_handle {
+        node_pool* pool = new node_pool;
+        ~pool_handle() { pool->orphan(); }
+    };
+
+    // Moi thread mot pool, dung chung giua cac hang doi cung kieu
+    static node_pool& local_pool() {
+        thread_local pool_handle handle;
+        return *handle.pool;
+    }
+
+    intrusive_mpsc_queue list_;
+    std::atomic<bool> closed_{false};
+    typename Wait::waiter not_empty_;
+
+public:
+    mpsc_queue() = default;
+
+    mpsc_queue(const mpsc_queue&) = delete;
+
+    ~mpsc_queue() {
+        while (try_dequeue()) {}
+    }
+
+    // Khong bao gio cho; false neu hang doi da dong
+    bool enqueue(const T& v) { return emplace(v); }
+    bool enqueue(T&& v) { return emplace(std::move(v)); }
+
+    template <typename... Args>
+    bool emplace(Args&&... args) {
+        if (closed_.load(std::memory_order_relaxed))
+            return false;
+        node* n = local_pool().acquire();
+        new (n->bytes) T(std::forward<Args>(args)...);
+        list_.push(n);
+        not_empty_.notify_one();
+        return true;
+    }
+
+    // Cac ham duoi day chi goi tu thread consumer
+
+    std::optional<T> try_dequeue() {
+        mpsc_node* n = list_.pop();
+        if (!n)
+            return std::nullopt;
+        return take(static_cast<node*>(n));
+    }
+
+    // nullopt khi hang doi da dong va da lay het
+    std::optional<T> dequeue() {
+        node* n = wait_pop();
+        if (!n)
+            return std::nullopt;
+        return take(n);
+    }
+
+    template <typename OutIt>
+    size_t try_dequeue_bulk(OutIt out, size_t max) {
+        size_t taken = 0;
+        for (mpsc_node* n; taken < max && (n = list_.pop()); ++taken)
+            *out++ = take(static_cast<node*>(n));
+        return taken;
+    }
+
+    // Cho den khi co it nhat mot phan tu; 0 khi hang doi da dong va rong
+    template <typename OutIt>
+    size_t dequeue_bulk(OutIt out, size_t max) {
+        if (max == 0)
+            return 0;
+        node* first = wait_pop();
+        if (!first)
+            return 0;
+        *out++ = take(first);
+        return 1 + try_dequeue_bulk(out, max - 1);
+    }
+
+    bool empty() const { return list_.empty(); }
+
+    // enqueue sau do that bai; phan tu cua producer dang enqueue dong thoi co the con lai
+    // trong hang doi sau khi consumer da nhan nullopt va bi huy cung hang doi
+    void close() {
+        closed_.store(true, std::memory_order_release);
+        not_empty_.notify_all();
+    }
+
+    bool closed() const {
+        return closed_.load(std::memory_order_acquire);
+    }
+
+private:
+    // Cho den khi lay duoc mot nut; nullptr khi hang doi da dong va rong. Predicate cua wait
+    // khong duoc co tac dung phu (wait goi no nhieu lan) nen chi kiem tra empty, pop sau khi cho
+    node* wait_pop() {
+        while (true) {
+            not_empty_.wait([&] { return !list_.empty() || closed(); });
+            if (mpsc_node* n = list_.pop())
+                return static_cast<node*>(n);
+            if (list_.empty() && closed())
+                return nullptr;
+            sched_yield(); // producer dang giua push: nut chua duoc lien ket
+        }
+    }
+
+    T take(node* n) {
+        T v(std::move(*n->value()));
+        n->value()->~T();
+        n->owner->give_back(n);
+        return v;
+    }
+};
+
+#endif // MPSC_QUEUE_HPP
@@ -0,0 +1,619 @@
+#ifndef MT_QUEUE_HPP
+#define MT_QUEUE_HPP
+
+#include <optional>
+#include <new>
+#include <cstdint>
+#include <utility>
+#include <atomic>
+#include <memory>
+#include <iterator>
+#include <algorithm>
+#include <type_traits>
+#include <stdexcept>
+#include <pthread.h>
+#include "check.hpp"
+#include "atomic_utils.hpp"
+#include "wait_policy.hpp"
+
+#ifdef MT_QUEUE_STATS
+#include <chrono>
+#endif
+
+// Chinh sach dong bo cua mt_queue, chon luc bien dich:
+//  mpmc - nhieu producer/consumer, mutex + condvar (mac dinh)
+//  spsc - dung mot producer va mot consumer, chi dung atomic acquire/release
+// Wait (wait_policy.hpp) quyet dinh thread bi chan cho the nao: condvar_wait ngu ngay,
+// spin_futex_wait spin/yield truoc roi moi ngu tren futex.
+struct mpmc {};
+struct spsc {};
+
+// Hanh vi cua enqueue/emplace/enqueue_bulk khi hang doi day (try_* luon that bai khi day):
+//  block_when_full  - cho den khi co cho (mac dinh)
+//  reject_when_full - tra ve false ngay, phan tu khong duoc them
+//  drop_newest      - bo phan tu moi nhung van tra ve true: producer khong can biet
+//  overwrite_oldest - huy phan tu cu nhat de lay cho (ring mat du lieu), chi mpmc
+// Ba chinh sach sau khong bao gio lam producer cho consumer. dropped chi dem phan tu that su bi
+// huy (drop_newest, overwrite_oldest); reject_when_full tra phan tu lai cho producer nen khong dem.
+struct block_when_full {};
+struct reject_when_full {};
+struct drop_newest {};
+struct overwrite_oldest {};
+
+// Anh chup so lieu cua mt_queue (mpmc). Chi dem khi bien dich voi -DMT_QUEUE_STATS,
+// khong co thi chi depth co gia tri va hang doi khong ton them gi.
+//  blocked_*     - so lan enqueue/dequeue phai cho (day/rong)
+//  *_wait_ns     - tong thoi gian cho tren not_full_/not_empty_
+//  lock_contended - so lan lay khoa thay khoa dang bi giu (trylock that bai)
+//  dropped       - so phan tu bi huy do chinh sach tran (luon dem)
+struct mt_queue_stats {
+#ifdef MT_QUEUE_STATS
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+    size_t depth = 0;
+    size_t high_water = 0;
+    uint64_t enqueued = 0;
+    uint64_t dequeued = 0;
+    uint64_t blocked_enqueues = 0;
+    uint64_t blocked_dequeues = 0;
+    uint64_t enqueue_wait_ns = 0;
+    uint64_t dequeue_wait_ns = 0;
+    uint64_t lock_acquisitions = 0;
+    uint64_t lock_contended = 0;
+    uint64_t dropped = 0;
+};
+
+// Dung luong 0 khong chua duoc phan tu nao: enqueue se cho mai hoac huy tren ring rong
+inline size_t checked_capacity(size_t max_size) {
+    if (max_size == 0)
+        throw std::invalid_argument("mt_queue: max_size must be positive");
+    return max_size;
+}
+
+template <typename T, typename Policy = mpmc, typename Wait = condvar_wait, typename Overflow = block_when_full>
+class mt_queue {
+    static constexpr bool blocking = std::is_same_v<Overflow, block_when_full>;
+
+    // o nho tho: phan tu chi duoc tao khi day vao va huy khi lay ra
+    struct slot {
+        alignas(T) unsigned char bytes[sizeof(T)];
+    };
+
+    size_t max_size_;
+    std::unique_ptr<slot[]> slots_; // cap phat mot lan, dung vong tron
+    size_t head_ = 0;               // vi tri phan tu dau
+    size_t size_ = 0;
+    mutable pthread_mutex_t mutex_;
+    typename Wait::waiter not_empty_, not_full_;
+    bool closed_ = false;
+    uint64_t dropped_ = 0;
+#ifdef MT_QUEUE_STATS
+    mutable mt_queue_stats stats_; // sua khi giu mutex_
+#endif
+public:
+    explicit mt_queue(size_t max_size) : max_size_(checked_capacity(max_size)), slots_(new slot[max_size_]) {
+        pthread_mutex_init(&mutex_, nullptr);
+    }
+
+    mt_queue(const mt_queue&) = delete;
+    mt_queue(mt_queue&&) = delete;
+
+    ~mt_queue() {
+        while (size_)
+            pop_front();
+        pthread_mutex_destroy(&mutex_);
+    }
+
+    // Tra ve false neu hang doi da dong (phan tu khong duoc them)
+    bool enqueue(const T& v) { return emplace(v); }
+    bool enqueue(T&& v) { return emplace(std::move(v)); }
+
+    // Tao phan tu ngay trong o cua hang doi, khong qua ban sao tam
+    template <typename... Args>
+    bool emplace(Args&&... args) {
+        lock();
+        if constexpr (blocking)
+            wait_not_full(); //wait consumer get value
+        if (closed_) {
+            unlock();
+            return false;
+        }
+        bool pushed = make_room();
+        if (pushed) {
+            push_back(std::forward<Args>(args)...);
+            not_empty_.notify_one();
+        }
+        unlock();
+        return pushed || std::is_same_v<Overflow, drop_newest>;
+    }
+
+    // Cho den khi co phan tu; tra ve nullopt khi hang doi da dong va da lay het
+    std::optional<T> dequeue() {
+        lock();
+        wait_not_empty();
+        if (size_ == 0) {
+            unlock();
+            return std::nullopt;
+        }
+        std::optional<T> val(std::move(front()));
+        pop_front();
+        not_full_.notify_one(); // bao cho producer rang co cho trong roi
+        unlock();
+        return val;
+    }
+
+    std::optional<T> try_dequeue() { //dung de lay
+        lock();
+        if (size_ == 0) {
+            unlock();
+            return std::nullopt;
+        }
+        std::optional<T> val(std::move(front()));
+        pop_front();
+        not_full_.notify_one();
+        unlock();
+        return val;
+    }
+
+    bool try_enqueue(const T& v) { return try_emplace(v); } //dung de ghi
+    bool try_enqueue(T&& v) { return try_emplace(std::move(v)); }
+
+    template <typename... Args>
+    bool try_emplace(Args&&... args) {
+        lock();
+        if (size_ >= max_size_ || closed_) {
+            unlock();
+            return false;
+        }
+        push_back(std::forward<Args>(args)...);
+        not_empty_.notify_one();
+        unlock();
+        return true;
+    }
+
+    // Day [first, last): moi lan giu khoa day nhieu phan tu nhat con cho,
+    // va chi danh thuc consumer mot lan cho moi dot. Tra ve so phan tu da day (it hon khi bi dong
+    // hoac bi tu choi; drop_newest tinh ca phan tu bi bo). Truyen std::move_iterator de chuyen thay vi chep
+    template <typename It>
+    size_t enqueue_bulk(It first, It last) {
+        size_t total = 0;
+        lock();
+        while (first != last) {
+            if constexpr (blocking)
+                wait_not_full();
+            if (closed_)
+                break;
+            size_t pushed = push_some(first, last);
+            if constexpr (!blocking)
+                if (first != last)
+                    total += overflow_bulk(first, last, pushed);
+            wake(not_empty_, pushed);
+            total += pushed;
+        }
+        unlock();
+        return total;
+    }
+
+    // Nhu enqueue_bulk nhung khong cho; tra ve so phan tu da day
+    template <typename It>
+    size_t try_enqueue_bulk(It first, It last) {
+        lock();
+        size_t pushed = closed_ ? 0 : push_some(first, last);
+        wake(not_empty_, pushed);
+        unlock();
+        return pushed;
+    }
+
+    // Cho den khi co it nhat mot phan tu roi chuyen toi da max phan tu vao out;
+    // tra ve so phan tu da lay, 0 khi hang doi da dong va rong
+    template <typename OutIt>
+    size_t dequeue_bulk(OutIt out, size_t max) {
+        if (max == 0)
+            return 0;
+        lock();
+        wait_not_empty();
+        size_t taken = pop_some(out, max);
+        wake(not_full_, taken);
+        unlock();
+        return taken;
+    }
+
+    template <typename OutIt>
+    size_t try_dequeue_bulk(OutIt out, size_t max) {
+        lock();
+        size_t taken = pop_some(out, max);
+        wake(not_full_, taken);
+        unlock();
+        return taken;
+    }
+
+    bool full() const {
+        lock();
+        bool result = size_ >= max_size_;
+        unlock();
+        return result;
+    }
+
+    bool empty() const {
+        lock();
+        bool result = size_ == 0;
+        unlock();
+        return result;
+    }
+
+    // Dong hang doi: enqueue sau do that bai, consumer dang cho duoc danh thuc
+    // va van lay not cac phan tu con lai truoc khi nhan nullopt
+    void close() {
+        lock();
+        closed_ = true;
+        not_empty_.notify_all();
+        not_full_.notify_all();
+        unlock();
+    }
+
+    bool closed() const {
+        lock();
+        bool result = closed_;
+        unlock();
+        return result;
+    }
+
+    mt_queue_stats stats() const {
+        lock();
+#ifdef MT_QUEUE_STATS
+        mt_queue_stats result = stats_;
+#else
+        mt_queue_stats result;
+#endif
+        result.depth = size_;
+        result.dropped = dropped_;
+        unlock();
+        return result;
+    }
+
+    uint64_t dropped() const {
+        lock();
+        uint64_t result = dropped_;
+        unlock();
+        return result;
+    }
+
+private:
+    void lock() const {
+#ifdef MT_QUEUE_STATS
+        int rc = pthread_mutex_trylock(&mutex_);
+        if (rc != 0) {
+            check_result(pthread_mutex_lock(&mutex_));
+            ++stats_.lock_contended;
+        }
+        ++stats_.lock_acquisitions;
+#else
+        check_result(pthread_mutex_lock(&mutex_));
+#endif
+    }
+
+    void unlock() const {
+        check_result(pthread_mutex_unlock(&mutex_));
+    }
+
+    // Cac ham duoi day goi khi dang giu mutex_
+    void wait_not_full() {
+        auto ready = [this] { return size_ < max_size_ || closed_; };
+#ifdef MT_QUEUE_STATS
+        if (ready())
+            return;
+        ++stats_.blocked_enqueues;
+        auto start = std::chrono::steady_clock::now();
+        not_full_.wait(mutex_, ready);
+        stats_.enqueue_wait_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+#else
+        not_full_.wait(mutex_, ready);
+#endif
+    }
+
+    void wait_not_empty() {
+        auto ready = [this] { return size_ > 0 || closed_; };
+#ifdef MT_QUEUE_STATS
+        if (ready())
+            return;
+        ++stats_.blocked_dequeues;
+        auto start = std::chrono::steady_clock::now();
+        not_empty_.wait(mutex_, ready);
+        stats_.dequeue_wait_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+#else
+        not_empty_.wait(mutex_, ready);
+#endif
+    }
+
+    T* at(size_t i) {
+        return std::launder(reinterpret_cast<T*>(slots_[i].bytes));
+    }
+
+    T& front() { return *at(head_); }
+
+    template <typename... Args>
+    void push_back(Args&&... args) {
+        size_t i = head_ + size_;
+        if (i >= max_size_)
+            i -= max_size_;
+        new (slots_[i].bytes) T(std::forward<Args>(args)...);
+        ++size_;
+#ifdef MT_QUEUE_STATS
+        ++stats_.enqueued;
+        stats_.high_water = std::max(stats_.high_water, size_);
+#endif
+    }
+
+    void pop_front() {
+        drop_front();
+#ifdef MT_QUEUE_STATS
+        ++stats_.dequeued;
+#endif
+    }
+
+    void drop_front() {
+        at(head_)->~T();
+        if (++head_ == max_size_)
+            head_ = 0;
+        --size_;
+    }
+
+    // true neu duoc day them mot phan tu; hang doi day thi ap dung Overflow
+    bool make_room() {
+        if (size_ < max_size_)
+            return true;
+        if constexpr (std::is_same_v<Overflow, overwrite_oldest>) {
+            drop_front();
+            ++dropped_;
+            return true;
+        }
+        if constexpr (std::is_same_v<Overflow, drop_newest>)
+            ++dropped_;
+        return false;
+    }
+
+    // Hang doi day giua mot dot: xu ly phan con lai [first, last) theo Overflow.
+    // Tra ve so phan tu bi bo nhung van tinh la da nhan (drop_newest)
+    template <typename It>
+    size_t overflow_bulk(It& first, It last, size_t& pushed) {
+        if constexpr (std::is_same_v<Overflow, overwrite_oldest>) {
+            for (; first != last; ++first, ++pushed, ++dropped_) {
+                drop_front();
+                push_back(*first);
+            }
+            return 0;
+        } else {
+            size_t rest = std::distance(first, last);
+            if constexpr (std::is_same_v<Overflow, drop_newest>)
+                dropped_ += rest;
+            first = last;
+            return std::is_same_v<Overflow, drop_newest> ? rest : 0;
+        }
+    }
+
+    template <typename It>
+    size_t push_some(It& first, It last) {
+        size_t pushed = 0;
+        for (; first != last && size_ < max_size_; ++first, ++pushed)
+            push_back(*first);
+        return pushed;
+    }
+
+    template <typename OutIt>
+    size_t pop_some(OutIt& out, size_t max) {
+        size_t taken = 0;
+        for (; taken < max && size_ > 0; ++taken) {
+            *out++ = std::move(front());
+            pop_front();
+        }
+        return taken;
+    }
+
+    // mot phan tu danh thuc mot thread, ca dot thi danh thuc tat ca
+    void wake(typename Wait::waiter& w, size_t n) {
+        if (n == 1)
+            w.notify_one();
+        else if (n > 1)
+            w.notify_all();
+    }
+};
+
+// Mot producer, mot consumer: moi chi so chi do mot ben ghi nen khong can khoa hay CAS.
+// Moi ben giu ban sao chi so cua ben kia va chi doc lai cache line cua ben kia
+// khi ban sao cho thay hang doi day (producer) hoac rong (consumer).
+// Ben bi chan cho qua waiter khong khoa cua Wait; notify chi ton syscall khi ben kia dang cho.
+// overwrite_oldest can producer lay phan tu cua consumer nen khong dung duoc voi spsc.
+template <typename T, typename Wait, typename Overflow>
+class mt_queue<T, spsc, Wait, Overflow> {
+    static_assert(!std::is_same_v<Overflow, overwrite_oldest>, "overwrite_oldest chi dung voi mpmc");
+    static constexpr bool blocking = std::is_same_v<Overflow, block_when_full>;
+
+    size_t max_size_;
+    size_t mask_;
+    std::unique_ptr<T[]> slots_;
+    alignas(CACHE_LINE) std::atomic<size_t> head_{0}; // consumer ghi
+    size_t cached_tail_ = 0;                          // consumer doc
+    alignas(CACHE_LINE) std::atomic<size_t> tail_{0}; // producer ghi
+    size_t cached_head_ = 0;                          // producer doc
+    std::atomic<uint64_t> dropped_{0};                // producer ghi
+    std::atomic<bool> closed_{false};
+    typename Wait::waiter not_empty_, not_full_;
+public:
+    explicit mt_queue(size_t max_size)
+        : max_size_(checked_capacity(max_size)),
+          mask_(round_up_pow2(max_size_) - 1),
+          slots_(new T[mask_ + 1]) {}
+
+    mt_queue(const mt_queue&) = delete;
+    mt_queue(mt_queue&&) = delete;
+
+    bool enqueue(const T& v) { return put(v); }
+    bool enqueue(T&& v) { return put(std::move(v)); }
+
+    // O da duoc tao san nen phan tu duoc tao mot lan roi chuyen vao o
+    template <typename... Args>
+    bool emplace(Args&&... args) {
+        return put(T(std::forward<Args>(args)...));
+    }
+
+    template <typename... Args>
+    bool try_emplace(Args&&... args) {
+        return try_put(T(std::forward<Args>(args)...));
+    }
+
+    std::optional<T> dequeue() {
+        while (true) {
+            if (auto v = try_dequeue())
+                return v;
+            if (closed_.load(std::memory_order_acquire))
+                return try_dequeue(); // phan tu day vao ngay truoc close
+            not_empty_.wait([this] { return !empty() || closed(); });
+        }
+    }
+
+    std::optional<T> try_dequeue() {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_)
+                return std::nullopt;
+        }
+        T val = std::move(slots_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release); // tra o cho producer
+        not_full_.notify_one();
+        return val;
+    }
+
+    bool try_enqueue(const T& v) { return try_put(v); }
+    bool try_enqueue(T&& v) { return try_put(std::move(v)); }
+
+    // Ca dot chi can mot lan store release chi so
+    template <typename It>
+    size_t try_enqueue_bulk(It first, It last) {
+        if (closed_.load(std::memory_order_relaxed))
+            return 0;
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t want = std::distance(first, last);
+        if (max_size_ - (tail - cached_head_) < want)
+            cached_head_ = head_.load(std::memory_order_acquire);
+        size_t n = std::min(want, max_size_ - (tail - cached_head_));
+        for (size_t i = 0; i < n; ++i, ++first)
+            slots_[(tail + i) & mask_] = *first;
+        if (n) {
+            tail_.store(tail + n, std::memory_order_release);
+            not_empty_.notify_one();
+        }
+        return n;
+    }
+
+    template <typename It>
+    size_t enqueue_bulk(It first, It last) {
+        size_t total = 0;
+        while (first != last && !closed_.load(std::memory_order_acquire)) {
+            size_t n = try_enqueue_bulk(first, last);
+            std::advance(first, n);
+            total += n;
+            if constexpr (!blocking) {
+                size_t rest = std::distance(first, last);
+                if (std::is_same_v<Overflow, drop_newest> && rest)
+                    count_dropped(rest);
+                return std::is_same_v<Overflow, drop_newest> ? total + rest : total;
+            }
+            if (n == 0)
+                not_full_.wait([this] { return !full() || closed(); });
+        }
+        return total;
+    }
+
+    template <typename OutIt>
+    size_t try_dequeue_bulk(OutIt out, size_t max) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (cached_tail_ - head < max)
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+        size_t n = std::min(max, cached_tail_ - head);
+        for (size_t i = 0; i < n; ++i)
+            *out++ = std::move(slots_[(head + i) & mask_]);
+        if (n) {
+            head_.store(head + n, std::memory_order_release);
+            not_full_.notify_one();
+        }
+        return n;
+    }
+
+    template <typename OutIt>
+    size_t dequeue_bulk(OutIt out, size_t max) {
+        if (max == 0)
+            return 0;
+        size_t n;
+        while ((n = try_dequeue_bulk(out, max)) == 0) {
+            if (closed_.load(std::memory_order_acquire))
+                return try_dequeue_bulk(out, max);
+            not_empty_.wait([this] { return !empty() || closed(); });
+        }
+        return n;
+    }
+
+    bool full() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire) >= max_size_;
+    }
+
+    bool empty() const {
+        return tail_.load(std::memory_order_acquire) == head_.load(std::memory_order_acquire);
+    }
+
+    void close() {
+        closed_.store(true, std::memory_order_release);
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+    bool closed() const {
+        return closed_.load(std::memory_order_acquire);
+    }
+
+    uint64_t dropped() const {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+private:
+    template <typename U>
+    bool put(U&& v) {
+        while (!try_put(std::forward<U>(v))) { // chi bi chuyen di khi thanh cong
+            if (closed_.load(std::memory_order_acquire))
+                return false;
+            if constexpr (!blocking) {
+                if constexpr (std::is_same_v<Overflow, drop_newest>)
+                    count_dropped(1);
+                return std::is_same_v<Overflow, drop_newest>;
+            }
+            not_full_.wait([this] { return !full() || closed(); });
+        }
+        return true;
+    }
+
+    void count_dropped(uint64_t n) {
+        dropped_.store(dropped_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    template <typename U>
+    bool try_put(U&& v) {
+        if (closed_.load(std::memory_order_relaxed))
+            return false;
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ >= max_size_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ >= max_size_)
+                return false;
+        }
+        slots_[tail & mask_] = std::forward<U>(v);
+        tail_.store(tail + 1, std::memory_order_release); // cong bo o cho consumer
+        not_empty_.notify_one();
+        return true;
+    }
+};
+
+#endif // MT_QUEUE_HPP
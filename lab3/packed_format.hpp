@@ -0,0 +1,230 @@
+#ifndef PACKED_FORMAT_HPP
+#define PACKED_FORMAT_HPP
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "check.hpp"
+#include "zone_map.hpp"
+
+// File int nen theo block ZONE_BLOCK_SIZE phan tu. Moi block chon cach ma hoa it bit hon:
+//  - frame-of-reference: code = v - min
+//  - delta (chi khi block khong giam): code = v - v_truoc, code[0] = 0
+// roi bit-pack cac code vao mang uint64. Header block giu min/max nen file tu co zone map.
+//
+// Bo cuc: PackedFileHeader | uint64 offset[block_count] | block... (offset tinh bang byte, can 8)
+constexpr uint32_t PACKED_MAGIC = 0x4b434150; // "PACK"
+
+enum class BlockEncoding : uint8_t { FrameOfReference = 0, Delta = 1 };
+
+struct PackedFileHeader {
+    uint32_t magic;
+    uint32_t block_size;
+    uint64_t element_count;
+    uint64_t block_count;
+};
+
+struct PackedBlockHeader {
+    int32_t min;
+    int32_t max;
+    int32_t first;
+    uint32_t count;
+    uint8_t encoding;
+    uint8_t bits;
+    uint8_t pad[6];
+};
+static_assert(sizeof(PackedBlockHeader) % sizeof(uint64_t) == 0, "blocks must stay 8-byte aligned");
+
+inline unsigned bits_needed(uint32_t x) {
+    return x ? 32 - __builtin_clz(x) : 0;
+}
+
+inline uint32_t packed_code(const uint64_t* words, unsigned bits, size_t i) {
+    size_t pos = i * bits;
+    size_t w = pos >> 6;
+    unsigned off = pos & 63;
+    uint64_t v = words[w] >> off;
+    if (off + bits > 64)
+        v |= words[w + 1] << (64 - off);
+    return (uint32_t)(v & ((uint64_t(1) << bits) - 1));
+}
+
+// Ghi block [data, data + n) vao cuoi out
+inline void pack_block(const int* data, size_t n, std::vector<uint64_t>& out) {
+    PackedBlockHeader h{};
+    auto [lo, hi] = std::minmax_element(data, data + n);
+    h.min = *lo;
+    h.max = *hi;
+    h.first = data[0];
+    h.count = (uint32_t)n;
+
+    unsigned for_bits = bits_needed((uint32_t)h.max - (uint32_t)h.min);
+    bool monotonic = std::is_sorted(data, data + n);
+    uint32_t max_delta = 0;
+    if (monotonic)
+        for (size_t i = 1; i < n; ++i)
+            max_delta = std::max(max_delta, (uint32_t)data[i] - (uint32_t)data[i - 1]);
+    unsigned delta_bits = bits_needed(max_delta);
+
+    bool delta = monotonic && delta_bits < for_bits;
+    h.encoding = (uint8_t)(delta ? BlockEncoding::Delta : BlockEncoding::FrameOfReference);
+    h.bits = (uint8_t)(delta ? delta_bits : for_bits);
+
+    size_t header_words = sizeof(h) / sizeof(uint64_t);
+    size_t base = out.size();
+    // them 1 word de packed_code doc words[w + 1] khong vuot qua block
+    out.resize(base + header_words + (n * h.bits + 63) / 64 + 1, 0);
+    memcpy(&out[base], &h, sizeof(h));
+    uint64_t* words = &out[base + header_words];
+    for (size_t i = 0; i < n && h.bits; ++i) {
+        uint32_t code = delta ? (i ? (uint32_t)data[i] - (uint32_t)data[i - 1] : 0)
+                              : (uint32_t)data[i] - (uint32_t)h.min;
+        size_t pos = i * h.bits;
+        words[pos >> 6] |= uint64_t(code) << (pos & 63);
+        if ((pos & 63) + h.bits > 64)
+            words[(pos >> 6) + 1] |= uint64_t(code) >> (64 - (pos & 63));
+    }
+}
+
+inline void write_packed_file(const std::string& path, const int* data, size_t n) {
+    size_t blocks = (n + ZONE_BLOCK_SIZE - 1) / ZONE_BLOCK_SIZE;
+    size_t header_words = sizeof(PackedFileHeader) / sizeof(uint64_t);
+    std::vector<uint64_t> buf(header_words + blocks);
+    PackedFileHeader fh{PACKED_MAGIC, (uint32_t)ZONE_BLOCK_SIZE, n, blocks};
+    memcpy(buf.data(), &fh, sizeof(fh));
+    for (size_t b = 0; b < blocks; ++b) {
+        buf[header_words + b] = buf.size() * sizeof(uint64_t);
+        size_t first = b * ZONE_BLOCK_SIZE;
+        pack_block(data + first, std::min(n - first, ZONE_BLOCK_SIZE), buf);
+    }
+    int fd = check(open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644));
+    pwrite_all(fd, buf.data(), buf.size() * sizeof(uint64_t), 0); // write don le bi cat o ~2 GiB
+    check(close(fd));
+}
+
+class PackedFile {
+    std::vector<uint64_t> buf_;
+
+    const PackedFileHeader& header() const {
+        return *reinterpret_cast<const PackedFileHeader*>(buf_.data());
+    }
+
+    const PackedBlockHeader& block_header(size_t b) const {
+        size_t offset = buf_[sizeof(PackedFileHeader) / sizeof(uint64_t) + b];
+        return *reinterpret_cast<const PackedBlockHeader*>(&buf_[offset / sizeof(uint64_t)]);
+    }
+
+    const uint64_t* block_words(size_t b) const {
+        return reinterpret_cast<const uint64_t*>(&block_header(b) + 1);
+    }
+
+public:
+    static bool is_packed(int fd) {
+        uint32_t magic = 0;
+        bool packed = pread(fd, &magic, sizeof(magic), 0) == (ssize_t)sizeof(magic) && magic == PACKED_MAGIC;
+        return packed;
+    }
+
+    // Doc toan bo file da nen vao bo nho; tra ve so byte da doc
+    size_t load(int fd) {
+        struct stat st{};
+        check(fstat(fd, &st));
+        buf_.assign((st.st_size + sizeof(uint64_t) - 1) / sizeof(uint64_t), 0);
+        size_t done = 0;
+        while (done < (size_t)st.st_size) {
+            ssize_t r = check(pread(fd, (char*)buf_.data() + done, st.st_size - done, done));
+            if (r == 0)
+                break;
+            done += r;
+        }
+        return done;
+    }
+
+    bool empty() const { return buf_.empty(); }
+    size_t size() const { return header().element_count; }
+    size_t block_count() const { return header().block_count; }
+    size_t bytes() const { return buf_.size() * sizeof(uint64_t); }
+
+    bool may_contain(size_t b, int lo, int hi) const {
+        const PackedBlockHeader& h = block_header(b);
+        return h.max >= lo && h.min <= hi;
+    }
+
+    // Giai nen block b vao out (dung cho tham chieu tuan tu)
+    void unpack_block(size_t b, int* out) const {
+        const PackedBlockHeader& h = block_header(b);
+        const uint64_t* words = block_words(b);
+        if (h.encoding == (uint8_t)BlockEncoding::Delta) {
+            uint32_t v = (uint32_t)h.first;
+            for (size_t i = 0; i < h.count; ++i) {
+                v += h.bits ? packed_code(words, h.bits, i) : 0;
+                out[i] = (int)v;
+            }
+        } else {
+            for (size_t i = 0; i < h.count; ++i)
+                out[i] = (int)((uint32_t)h.min + (h.bits ? packed_code(words, h.bits, i) : 0));
+        }
+    }
+
+    // Goi f(chi so toan cuc) cho moi phan tu cua block b nam trong [lo, hi], tinh tren code
+    // da nen ma khong giai nen ra mang. f tra ve false de dung; ham tra ve false neu bi dung.
+    template <typename F>
+    bool for_each_match(size_t b, int lo, int hi, bool reverse, F&& f) const {
+        const PackedBlockHeader& h = block_header(b);
+        if (h.max < lo || h.min > hi)
+            return true;
+        const uint64_t* words = block_words(b);
+        size_t base = b * header().block_size;
+        size_t n = h.count;
+
+        if (h.bits == 0) { // ca block cung mot gia tri va gia tri do thoa
+            for (size_t j = 0; j < n; ++j)
+                if (!f(base + (reverse ? n - 1 - j : j)))
+                    return false;
+            return true;
+        }
+
+        if (h.encoding == (uint8_t)BlockEncoding::Delta) {
+            // block khong giam: cong don delta, dung ngay khi vuot qua khoang
+            if (!reverse) {
+                int64_t v = h.first;
+                for (size_t i = 0; i < n; ++i) {
+                    if (i)
+                        v += packed_code(words, h.bits, i);
+                    if (v > hi)
+                        break;
+                    if (v >= lo && !f(base + i))
+                        return false;
+                }
+            } else {
+                int64_t v = h.max; // phan tu cuoi cua block khong giam
+                for (size_t i = n; i > 0; --i) {
+                    if (v < lo)
+                        break;
+                    if (v <= hi && !f(base + i - 1))
+                        return false;
+                    if (i > 1)
+                        v -= packed_code(words, h.bits, i - 1);
+                }
+            }
+            return true;
+        }
+
+        // frame-of-reference: so sanh code voi [lo - min, hi - min]
+        uint32_t clo = (uint32_t)(std::max<int64_t>(lo, h.min) - h.min);
+        uint32_t width = (uint32_t)(std::min<int64_t>(hi, h.max) - h.min) - clo;
+        for (size_t j = 0; j < n; ++j) {
+            size_t i = reverse ? n - 1 - j : j;
+            if (packed_code(words, h.bits, i) - clo <= width && !f(base + i))
+                return false;
+        }
+        return true;
+    }
+};
+
+#endif // PACKED_FORMAT_HPP
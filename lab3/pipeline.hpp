@@ -0,0 +1,335 @@
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <string>
+#include <optional>
+#include <iterator>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <pthread.h>
+#include <unistd.h>
+#include "check.hpp"
+#include "atomic_utils.hpp"
+#include "mt_queue.hpp"
+
+// Pipeline nhieu tang tren mt_queue: source -> transform... -> sink. Moi tang chay so thread
+// tuy chon, cac tang noi nhau bang mt_queue co gioi han (tang sau cham thi tang truoc bi chan).
+// Ket thuc theo thu tu: thread cuoi cung cua mot tang dong hang doi ra cua no, tang sau lay
+// not phan tu con lai roi ket thuc theo. stop() chi dung source, phan tu da sinh van duoc xu ly.
+//
+//   pipeline p(1024);
+//   auto lines = p.source<std::string>("read", 1, [&]() -> std::optional<std::string> {...});
+//   auto words = p.transform<int>("count", 4, lines, [](std::string s) { return ...; });
+//   p.sink("sum", 1, words, [&](int n) { total += n; });
+//   p.run();
+//
+// Ham cua tang co parallelism > 1 duoc goi dong thoi tu nhieu thread. Transform tra ve
+// std::optional<Out> thi nullopt nghia la bo phan tu (loc).
+class pipeline {
+public:
+    static constexpr size_t BATCH = 64; // so phan tu transform/sink lay mot lan giu khoa
+
+    // Dau ra cua mot tang; moi port phai duoc dung lam dau vao cho dung mot tang
+    template <typename T>
+    class port {
+        friend class pipeline;
+        mt_queue<T>* queue_;
+        size_t stage_;
+        port(mt_queue<T>* queue, size_t stage) : queue_(queue), stage_(stage) {}
+    };
+
+    explicit pipeline(size_t queue_capacity) : capacity_(queue_capacity) {}
+
+    pipeline(const pipeline&) = delete;
+
+    ~pipeline() {
+        stop();
+        join();
+    }
+
+    // fn() -> std::optional<Out>; nullopt khi het du lieu
+    template <typename Out, typename Fn>
+    port<Out> source(std::string name, size_t parallelism, Fn fn) {
+        auto* s = new source_stage<Out, Fn>(std::move(name), parallelism, capacity_, std::move(fn), stop_);
+        add(s);
+        return port<Out>(&s->out, stages_.size() - 1);
+    }
+
+    // fn(In) -> Out hoac std::optional<Out>
+    template <typename Out, typename In, typename Fn>
+    port<Out> transform(std::string name, size_t parallelism, port<In> in, Fn fn) {
+        auto* s = new transform_stage<In, Out, Fn>(std::move(name), parallelism, capacity_, connect(in), std::move(fn));
+        add(s);
+        return port<Out>(&s->out, stages_.size() - 1);
+    }
+
+    // fn(In)
+    template <typename In, typename Fn>
+    void sink(std::string name, size_t parallelism, port<In> in, Fn fn) {
+        add(new sink_stage<In, Fn>(std::move(name), parallelism, connect(in), std::move(fn)));
+    }
+
+    // Khoi dong moi tang va cho den khi sink cuoi cung xong.
+    // report_interval > 0: in so lieu tung tang ra os theo chu ky
+    void run(std::chrono::milliseconds report_interval = std::chrono::milliseconds(0), std::ostream& os = std::cout) {
+        start();
+        if (report_interval.count() > 0) {
+            auto next = std::chrono::steady_clock::now() + report_interval;
+            while (running_stages_.load(std::memory_order_acquire) > 0) {
+                usleep(POLL_US);
+                sample_depths();
+                if (std::chrono::steady_clock::now() >= next) {
+                    report(os);
+                    next += report_interval;
+                }
+            }
+        }
+        join();
+        report(os);
+    }
+
+    // Khoi dong khong cho; ket thuc bang stop() va/hoac join()
+    void start() {
+        for (auto& s : stages_)
+            if (s->has_output && !s->output_connected)
+                throw std::logic_error("pipeline: output of stage '" + s->name + "' is not consumed");
+        running_stages_.store(stages_.size(), std::memory_order_relaxed);
+        for (auto& s : stages_) {
+            s->start_ns = now_ns();
+            // +1 giu tang song den khi tao xong: worker ket thuc som khong duoc dong hang doi ra
+            s->running.store(1, std::memory_order_relaxed);
+            s->threads.clear();
+            for (size_t i = 0; i < s->parallelism; ++i) {
+                s->args[i] = {this, s.get(), i};
+                pthread_t t;
+                s->running.fetch_add(1, std::memory_order_relaxed);
+                check_result(pthread_create(&t, nullptr, worker, &s->args[i]));
+                s->threads.push_back(t);
+            }
+            worker_done(this, s.get());
+        }
+        started_ = true;
+    }
+
+    // Source ngung sinh; cac tang sau xu ly not phan tu dang co trong hang doi
+    void stop() {
+        stop_.store(true, std::memory_order_relaxed);
+    }
+
+    void join() {
+        if (!started_)
+            return;
+        for (auto& s : stages_)
+            for (pthread_t t : s->threads)
+                pthread_join(t, nullptr);
+        started_ = false;
+    }
+
+    // Moi tang: so thread, so phan tu da xu ly, thong luong, do sau hang doi vao (hien tai/lon nhat da thay)
+    void report(std::ostream& os) const {
+        os << std::left << std::setw(16) << "stage" << std::right << std::setw(8) << "threads"
+           << std::setw(12) << "items" << std::setw(14) << "items/s" << std::setw(10) << "queue"
+           << std::setw(10) << "max queue" << "\n";
+        for (auto& s : stages_) {
+            uint64_t items = s->processed();
+            uint64_t end = s->end_ns.load(std::memory_order_acquire);
+            double seconds = ((end ? end : now_ns()) - s->start_ns) / 1e9;
+            os << std::left << std::setw(16) << s->name << std::right << std::setw(8) << s->threads.size()
+               << std::setw(12) << items << std::setw(14) << (uint64_t)(seconds > 0 ? items / seconds : 0)
+               << std::setw(10) << s->input_depth() << std::setw(10) << s->max_depth << "\n";
+        }
+        os << std::flush;
+    }
+
+private:
+    static constexpr useconds_t POLL_US = 10000;
+
+    struct alignas(CACHE_LINE) counter {
+        std::atomic<uint64_t> value{0}; // chi thread so huu ghi
+    };
+
+    struct stage_base;
+
+    struct worker_arg {
+        pipeline* owner;
+        stage_base* stage;
+        size_t index;
+    };
+
+    struct stage_base {
+        std::string name;
+        size_t parallelism;
+        bool has_output;
+        bool output_connected = false;
+        std::vector<pthread_t> threads;
+        std::vector<worker_arg> args;
+        std::unique_ptr<counter[]> counts; // moi thread mot bo dem, khong tranh chap
+        std::atomic<size_t> running{0};
+        uint64_t start_ns = 0;
+        std::atomic<uint64_t> end_ns{0};
+        size_t max_depth = 0; // chi thread goi run() ghi
+
+        stage_base(std::string n, size_t p, bool output)
+            : name(std::move(n)), parallelism(p ? p : 1), has_output(output),
+              args(parallelism), counts(new counter[parallelism]) {}
+
+        virtual ~stage_base() = default;
+        virtual void work(size_t index) = 0;
+        virtual void close_output() = 0;
+        virtual size_t input_depth() const = 0;
+
+        void count(size_t index, size_t n) {
+            counts[index].value.store(counts[index].value.load(std::memory_order_relaxed) + n,
+                                      std::memory_order_relaxed);
+        }
+
+        uint64_t processed() const {
+            uint64_t total = 0;
+            for (size_t i = 0; i < parallelism; ++i)
+                total += counts[i].value.load(std::memory_order_relaxed);
+            return total;
+        }
+    };
+
+    template <typename Out, typename Fn>
+    struct source_stage : stage_base {
+        mt_queue<Out> out;
+        Fn fn;
+        const std::atomic<bool>& stop;
+
+        source_stage(std::string n, size_t p, size_t capacity, Fn f, const std::atomic<bool>& s)
+            : stage_base(std::move(n), p, true), out(capacity), fn(std::move(f)), stop(s) {}
+
+        void work(size_t index) override {
+            while (!stop.load(std::memory_order_relaxed)) {
+                std::optional<Out> v = fn();
+                if (!v)
+                    break;
+                out.enqueue(std::move(*v));
+                this->count(index, 1);
+            }
+        }
+
+        void close_output() override { out.close(); }
+        size_t input_depth() const override { return 0; }
+    };
+
+    template <typename T>
+    struct is_optional : std::false_type {};
+
+    template <typename T>
+    struct is_optional<std::optional<T>> : std::true_type {};
+
+    template <typename In, typename Out, typename Fn>
+    struct transform_stage : stage_base {
+        mt_queue<In>* in;
+        mt_queue<Out> out;
+        Fn fn;
+
+        transform_stage(std::string n, size_t p, size_t capacity, mt_queue<In>* i, Fn f)
+            : stage_base(std::move(n), p, true), in(i), out(capacity), fn(std::move(f)) {}
+
+        void work(size_t index) override {
+            std::vector<In> batch;
+            std::vector<Out> results;
+            batch.reserve(BATCH);
+            results.reserve(BATCH);
+            while (in->dequeue_bulk(std::back_inserter(batch), BATCH) > 0) {
+                for (In& v : batch) {
+                    if constexpr (is_optional<std::invoke_result_t<Fn&, In&&>>::value) {
+                        if (auto r = fn(std::move(v)))
+                            results.push_back(std::move(*r));
+                    } else {
+                        results.push_back(fn(std::move(v)));
+                    }
+                }
+                out.enqueue_bulk(std::make_move_iterator(results.begin()), std::make_move_iterator(results.end()));
+                this->count(index, batch.size());
+                batch.clear();
+                results.clear();
+            }
+        }
+
+        void close_output() override { out.close(); }
+        size_t input_depth() const override { return in->stats().depth; }
+    };
+
+    template <typename In, typename Fn>
+    struct sink_stage : stage_base {
+        mt_queue<In>* in;
+        Fn fn;
+
+        sink_stage(std::string n, size_t p, mt_queue<In>* i, Fn f)
+            : stage_base(std::move(n), p, false), in(i), fn(std::move(f)) {}
+
+        void work(size_t index) override {
+            std::vector<In> batch;
+            batch.reserve(BATCH);
+            while (in->dequeue_bulk(std::back_inserter(batch), BATCH) > 0) {
+                for (In& v : batch)
+                    fn(std::move(v));
+                this->count(index, batch.size());
+                batch.clear();
+            }
+        }
+
+        void close_output() override {}
+        size_t input_depth() const override { return in->stats().depth; }
+    };
+
+    size_t capacity_;
+    std::vector<std::unique_ptr<stage_base>> stages_;
+    std::atomic<bool> stop_{false};
+    std::atomic<size_t> running_stages_{0};
+    bool started_ = false;
+
+    static uint64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void add(stage_base* s) {
+        if (started_)
+            throw std::logic_error("pipeline: cannot add stage '" + s->name + "' after start");
+        stages_.emplace_back(s);
+    }
+
+    template <typename T>
+    mt_queue<T>* connect(port<T> p) {
+        stage_base& producer = *stages_.at(p.stage_);
+        if (producer.output_connected)
+            throw std::logic_error("pipeline: output of stage '" + producer.name + "' is already consumed");
+        producer.output_connected = true;
+        return p.queue_;
+    }
+
+    void sample_depths() {
+        for (auto& s : stages_)
+            s->max_depth = std::max(s->max_depth, s->input_depth());
+    }
+
+    static void* worker(void* arg) {
+        auto* a = (worker_arg*)arg;
+        a->stage->work(a->index);
+        worker_done(a->owner, a->stage);
+        return nullptr;
+    }
+
+    // Thread cuoi cung cua tang dong hang doi ra: tang sau ket thuc khi lay het
+    static void worker_done(pipeline* owner, stage_base* stage) {
+        if (stage->running.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            stage->end_ns.store(now_ns(), std::memory_order_release);
+            stage->close_output();
+            owner->running_stages_.fetch_sub(1, std::memory_order_release);
+        }
+    }
+};
+
+#endif // PIPELINE_HPP
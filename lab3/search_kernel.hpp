@@ -0,0 +1,87 @@
+#ifndef SEARCH_KERNEL_HPP
+#define SEARCH_KERNEL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Kernel quet [lo, hi] tren mang T bang vector extension cua GCC: moi kieu phan tu duoc bien
+// dich thanh lenh SIMD rieng. Vector 16 byte (SSE2/NEON) = 16 int8, 8 int16, 4 int32/float,
+// 2 int64/double; build voi -mavx2 thi vector 32 byte.
+template <typename T>
+struct SearchKernel {
+#ifdef __AVX2__
+    static constexpr size_t VECTOR_BYTES = 32;
+#else
+    static constexpr size_t VECTOR_BYTES = 16;
+#endif
+    static constexpr size_t LANES = VECTOR_BYTES / sizeof(T);
+    typedef T vec __attribute__((vector_size(VECTOR_BYTES)));
+    using mask = decltype(vec{} < vec{}); // moi lane la 0 hoac -1
+
+    static vec load(const T* p) {
+        vec v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    static mask in_range(vec v, T lo, T hi) {
+        return (v >= lo) & (v <= hi);
+    }
+
+    static bool any(mask m) {
+        uint64_t w[VECTOR_BYTES / sizeof(uint64_t)];
+        memcpy(w, &m, sizeof(w));
+        uint64_t acc = 0;
+        for (uint64_t x : w)
+            acc |= x;
+        return acc != 0;
+    }
+
+    static size_t count(const T* p, size_t n, T lo, T hi) {
+        size_t total = 0;
+        size_t i = 0;
+        while (i + LANES <= n) {
+            // lane cua mask la so nguyen co dau cung kich thuoc voi T: int8 chi chiu duoc 127 lan cong
+            mask acc{};
+            for (int r = 0; r < 127 && i + LANES <= n; ++r, i += LANES)
+                acc += in_range(load(p + i), lo, hi);
+            for (size_t l = 0; l < LANES; ++l)
+                total += (size_t)(-(int64_t)acc[l]);
+        }
+        for (; i < n; ++i)
+            total += p[i] >= lo && p[i] <= hi;
+        return total;
+    }
+
+    // Goi f(base + i) cho moi p[i] trong [lo, hi]; f tra ve false de dung, khi do ham tra ve false
+    template <typename F>
+    static bool for_each_match(const T* p, size_t base, size_t n, T lo, T hi, bool reverse, F&& f) {
+        size_t vectors = n / LANES;
+        size_t tail = vectors * LANES;
+        if (reverse) {
+            for (size_t i = n; i > tail; --i)
+                if (p[i - 1] >= lo && p[i - 1] <= hi && !f(base + i - 1))
+                    return false;
+        }
+        for (size_t j = 0; j < vectors; ++j) {
+            size_t v = reverse ? vectors - 1 - j : j;
+            mask m = in_range(load(p + v * LANES), lo, hi);
+            if (!any(m))
+                continue;
+            for (size_t l = 0; l < LANES; ++l) {
+                size_t lane = reverse ? LANES - 1 - l : l;
+                if (m[lane] && !f(base + v * LANES + lane))
+                    return false;
+            }
+        }
+        if (!reverse) {
+            for (size_t i = tail; i < n; ++i)
+                if (p[i] >= lo && p[i] <= hi && !f(base + i))
+                    return false;
+        }
+        return true;
+    }
+};
+
+#endif // SEARCH_KERNEL_HPP
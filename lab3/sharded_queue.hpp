@@ -0,0 +1,138 @@
+#ifndef SHARDED_QUEUE_HPP
+#define SHARDED_QUEUE_HPP
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <vector>
+#include <utility>
+#include <functional>
+#include "atomic_utils.hpp"
+#include "wait_policy.hpp"
+#include "mt_queue.hpp"
+
+// Moi consumer mot mt_queue rieng (shard) nen consumer khong tranh nhau cung mot mutex.
+// Producer dat phan tu theo vong tron (hoac theo key), consumer lay o shard cua minh truoc,
+// shard rong thi lay trom tu shard khac, tat ca rong thi ngu tren idle_. Producer thay moi shard
+// deu day thi ngu tren not_full_ (consumer bao sau moi lan lay duoc) roi thu lai ca vong.
+// Consumer i goi dequeue(i) voi i < shard_count().
+template <typename T, typename Wait = condvar_wait>
+class sharded_queue {
+    struct alignas(CACHE_LINE) shard {
+        mt_queue<T, mpmc, Wait> queue;
+        explicit shard(size_t capacity) : queue(capacity) {}
+    };
+
+    std::vector<std::unique_ptr<shard>> shards_;
+    typename Wait::waiter idle_;     // consumer khong tim thay gi o moi shard
+    typename Wait::waiter not_full_; // producer thay moi shard deu day
+    std::atomic<bool> closed_{false};
+public:
+    sharded_queue(size_t shard_count, size_t capacity_per_shard) {
+        if (shard_count == 0)
+            shard_count = 1;
+        for (size_t i = 0; i < shard_count; ++i)
+            shards_.emplace_back(new shard(capacity_per_shard));
+    }
+
+    sharded_queue(const sharded_queue&) = delete;
+    sharded_queue(sharded_queue&&) = delete;
+
+    size_t shard_count() const { return shards_.size(); }
+
+    // Vong tron: thu dat vao tung shard bat dau tu con tro rieng cua thread, moi shard deu day
+    // thi cho den khi mot shard bat ky co cho roi thu lai. Tra ve false khi da dong
+    template <typename U>
+    bool enqueue(U&& v) {
+        size_t n = shards_.size();
+        size_t start = next_shard() % n;
+        while (!closed()) {
+            for (size_t i = 0; i < n; ++i) {
+                size_t s = start + i < n ? start + i : start + i - n;
+                if (shards_[s]->queue.try_enqueue(std::forward<U>(v))) { // chi bi chuyen di khi thanh cong
+                    idle_.notify_one();
+                    return true;
+                }
+            }
+            not_full_.wait([this] { return !full() || closed(); });
+        }
+        return false;
+    }
+
+    // Dat theo key: cac phan tu cung key vao cung shard nen giu thu tu voi nhau
+    // (tru khi bi consumer khac lay trom)
+    template <typename Key, typename U>
+    bool enqueue_hashed(const Key& key, U&& v) {
+        return enqueue_to(std::hash<Key>{}(key) % shards_.size(), std::forward<U>(v));
+    }
+
+    // Cho den khi co phan tu; nullopt khi da dong va moi shard deu rong
+    std::optional<T> dequeue(size_t id) {
+        while (true) {
+            if (auto v = try_dequeue(id))
+                return v;
+            if (closed_.load(std::memory_order_acquire))
+                return try_dequeue(id); // phan tu day vao ngay truoc close
+            idle_.wait([this] { return !empty() || closed(); });
+        }
+    }
+
+    // Shard cua minh truoc, sau do trom tu cac shard ke tiep
+    std::optional<T> try_dequeue(size_t id) {
+        size_t n = shards_.size();
+        id %= n;
+        for (size_t i = 0; i < n; ++i) {
+            size_t s = id + i < n ? id + i : id + i - n;
+            if (auto v = shards_[s]->queue.try_dequeue()) {
+                not_full_.notify_one();
+                return v;
+            }
+        }
+        return std::nullopt;
+    }
+
+    bool empty() const {
+        for (auto& s : shards_)
+            if (!s->queue.empty())
+                return false;
+        return true;
+    }
+
+    // Moi shard deu day
+    bool full() const {
+        for (auto& s : shards_)
+            if (!s->queue.full())
+                return false;
+        return true;
+    }
+
+    void close() {
+        closed_.store(true, std::memory_order_release);
+        for (auto& s : shards_)
+            s->queue.close();
+        idle_.notify_all();
+        not_full_.notify_all();
+    }
+
+    bool closed() const {
+        return closed_.load(std::memory_order_acquire);
+    }
+
+private:
+    template <typename U>
+    bool enqueue_to(size_t s, U&& v) {
+        if (!shards_[s]->queue.enqueue(std::forward<U>(v)))
+            return false;
+        idle_.notify_one();
+        return true;
+    }
+
+    // Con tro vong tron rieng moi thread: producer khong tranh nhau mot bien dem chung
+    static size_t next_shard() {
+        static std::atomic<size_t> seed{0};
+        thread_local size_t cursor = seed.fetch_add(1, std::memory_order_relaxed);
+        return cursor++;
+    }
+};
+
+#endif // SHARDED_QUEUE_HPP
@@ -0,0 +1,252 @@
+#ifndef SHM_QUEUE_HPP
+#define SHM_QUEUE_HPP
+
+#include <optional>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+#include <utility>
+#include <type_traits>
+#include <atomic>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "check.hpp"
+
+// mt_queue trong vung nho chia se (shm_open + mmap) de cac process trao doi phan tu ma khong
+// qua syscall/copy cua pipe hay message queue. Mutex/condvar PTHREAD_PROCESS_SHARED nam ngay
+// trong vung nho; mutex la robust nen process chet khi dang giu khoa khong lam treo process khac.
+// Phan tu duoc chep nguyen byte vao o co kich thuoc co dinh nen T phai trivially copyable
+// (khong chua con tro: dia chi khac nhau giua cac process).
+// head/tail la bo dem tang mai; moi thao tac chi ghi mot trong hai sau khi da chep xong phan tu,
+// nen process chet giua chung khong de lai hang doi lech (xem recover).
+template <typename T>
+class shm_queue {
+    static_assert(std::is_trivially_copyable<T>::value, "shm_queue can T trivially copyable");
+
+    static constexpr uint64_t MAGIC = 0x3255514d48534c33ull; // "3LSHMQU2"
+
+    struct header {
+        uint64_t magic;
+        uint64_t element_size;
+        uint64_t capacity;
+        pthread_mutex_t mutex;
+        pthread_cond_t not_empty, not_full;
+        uint64_t head; // so phan tu da lay ra; o cua phan tu dau la head % capacity
+        uint64_t tail; // so phan tu da them; size = tail - head
+        bool closed;
+    };
+
+    header* h_ = nullptr;
+    T* slots_ = nullptr;
+    size_t mapped_ = 0;
+
+    static size_t mapping_size(size_t capacity) {
+        size_t slots_offset = (sizeof(header) + alignof(T) - 1) / alignof(T) * alignof(T);
+        return slots_offset + capacity * sizeof(T);
+    }
+
+    shm_queue(void* base, size_t mapped) : h_((header*)base), mapped_(mapped) {
+        size_t slots_offset = mapping_size(0);
+        slots_ = (T*)((char*)base + slots_offset);
+    }
+
+    void init(size_t capacity) {
+        h_->magic = MAGIC;
+        h_->element_size = sizeof(T);
+        h_->capacity = capacity;
+        h_->head = 0;
+        h_->tail = 0;
+        h_->closed = false;
+
+        pthread_mutexattr_t ma;
+        pthread_mutexattr_init(&ma);
+        check_result(pthread_mutexattr_setpshared(&ma, PTHREAD_PROCESS_SHARED));
+        check_result(pthread_mutexattr_setrobust(&ma, PTHREAD_MUTEX_ROBUST));
+        check_result(pthread_mutex_init(&h_->mutex, &ma));
+        pthread_mutexattr_destroy(&ma);
+
+        pthread_condattr_t ca;
+        pthread_condattr_init(&ca);
+        check_result(pthread_condattr_setpshared(&ca, PTHREAD_PROCESS_SHARED));
+        check_result(pthread_cond_init(&h_->not_empty, &ca));
+        check_result(pthread_cond_init(&h_->not_full, &ca));
+        pthread_condattr_destroy(&ca);
+    }
+
+public:
+    // Tao segment moi ten name (vd "/lab3_queue"). Da co segment cung ten thi loi EEXIST (co the
+    // dang duoc process khac dung), tru khi replace_existing: segment cu bi xoa truoc
+    static shm_queue create(const char* name, size_t capacity, bool replace_existing = false) {
+        if (replace_existing)
+            unlink(name);
+        int fd = check(shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600));
+        size_t size = mapping_size(capacity);
+        check(ftruncate(fd, size));
+        void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        check(::close(fd));
+        if (base == MAP_FAILED)
+            check(-1);
+        shm_queue q(base, size);
+        q.init(capacity);
+        return q;
+    }
+
+    // Mo segment da duoc create o process khac
+    static shm_queue open(const char* name) {
+        int fd = check(shm_open(name, O_RDWR, 0));
+        struct stat st{};
+        check(fstat(fd, &st));
+        void* base = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        check(::close(fd));
+        if (base == MAP_FAILED)
+            check(-1);
+        shm_queue q(base, st.st_size);
+        if ((size_t)st.st_size < sizeof(header) || q.h_->magic != MAGIC || q.h_->element_size != sizeof(T)
+            || mapping_size(q.h_->capacity) > (size_t)st.st_size) {
+            errno = EINVAL; // khong phai shm_queue<T>
+            check(-1);
+        }
+        return q;
+    }
+
+    // Khong ten: chi chia se voi cac process fork() sau do
+    static shm_queue create_anonymous(size_t capacity) {
+        size_t size = mapping_size(capacity);
+        void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED)
+            check(-1);
+        shm_queue q(base, size);
+        q.init(capacity);
+        return q;
+    }
+
+    static void unlink(const char* name) {
+        check_except(shm_unlink(name), ENOENT);
+    }
+
+    shm_queue(shm_queue&& o) noexcept
+        : h_(std::exchange(o.h_, nullptr)), slots_(o.slots_), mapped_(std::exchange(o.mapped_, 0)) {}
+
+    shm_queue(const shm_queue&) = delete;
+    shm_queue& operator=(const shm_queue&) = delete;
+
+    // Chi go mapping cua process nay; segment con ton tai den khi unlink
+    ~shm_queue() {
+        if (h_)
+            munmap(h_, mapped_);
+    }
+
+    size_t capacity() const { return h_->capacity; }
+
+    // Tra ve false neu hang doi da dong
+    bool enqueue(const T& v) {
+        lock();
+        while (size() >= h_->capacity && !h_->closed)
+            wait(&h_->not_full);
+        bool ok = !h_->closed;
+        if (ok)
+            push(v);
+        unlock();
+        return ok;
+    }
+
+    bool try_enqueue(const T& v) {
+        lock();
+        bool ok = size() < h_->capacity && !h_->closed;
+        if (ok)
+            push(v);
+        unlock();
+        return ok;
+    }
+
+    // Cho den khi co phan tu; nullopt khi hang doi da dong va da lay het
+    std::optional<T> dequeue() {
+        lock();
+        while (size() == 0 && !h_->closed)
+            wait(&h_->not_empty);
+        std::optional<T> v = pop();
+        unlock();
+        return v;
+    }
+
+    std::optional<T> try_dequeue() {
+        lock();
+        std::optional<T> v = pop();
+        unlock();
+        return v;
+    }
+
+    void close() {
+        lock();
+        h_->closed = true;
+        check_result(pthread_cond_broadcast(&h_->not_empty));
+        check_result(pthread_cond_broadcast(&h_->not_full));
+        unlock();
+    }
+
+    bool closed() {
+        lock();
+        bool result = h_->closed;
+        unlock();
+        return result;
+    }
+
+    bool empty() {
+        lock();
+        bool result = size() == 0;
+        unlock();
+        return result;
+    }
+
+    bool full() {
+        lock();
+        bool result = size() >= h_->capacity;
+        unlock();
+        return result;
+    }
+
+private:
+    // Chu cu cua khoa da chet: trang thai hang doi van nhat quan vi moi thao tac chi ghi mot
+    // bo dem (tail sau khi chep vao o, head sau khi chep ra), nen chi can danh dau mutex dung
+    // duoc tiep. Phan tu ma consumer chet truoc khi ghi head van con trong hang doi
+    void recover(int rc) {
+        if (rc == EOWNERDEAD)
+            check_result(pthread_mutex_consistent(&h_->mutex));
+        else
+            check_result(rc);
+    }
+
+    void lock() { recover(pthread_mutex_lock(&h_->mutex)); }
+    void unlock() { check_result(pthread_mutex_unlock(&h_->mutex)); }
+    void wait(pthread_cond_t* c) { recover(pthread_cond_wait(c, &h_->mutex)); }
+
+    // Cac ham duoi day goi khi dang giu mutex
+    uint64_t size() const { return h_->tail - h_->head; }
+
+    // signal fence: compiler khong duoc doi viec ghi bo dem len truoc memcpy (process co the
+    // chet o bat ky lenh nao)
+    void push(const T& v) {
+        uint64_t tail = h_->tail;
+        memcpy((void*)&slots_[tail % h_->capacity], &v, sizeof(T));
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        h_->tail = tail + 1;
+        check_result(pthread_cond_signal(&h_->not_empty));
+    }
+
+    std::optional<T> pop() {
+        uint64_t head = h_->head;
+        if (h_->tail == head)
+            return std::nullopt;
+        T v;
+        memcpy((void*)&v, &slots_[head % h_->capacity], sizeof(T));
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        h_->head = head + 1;
+        check_result(pthread_cond_signal(&h_->not_full));
+        return v;
+    }
+};
+
+#endif // SHM_QUEUE_HPP
@@ -0,0 +1,176 @@
+#ifndef WAIT_POLICY_HPP
+#define WAIT_POLICY_HPP
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "check.hpp"
+#include "atomic_utils.hpp"
+
+// Chinh sach cho cua hang doi. Moi chinh sach co kieu waiter voi:
+//  wait(m, ready) - goi khi dang giu mutex m; cho den khi ready() (kiem tra duoi m) dung
+//  wait(ready)    - cho hang doi khong khoa; ready() phai doc trang thai bang atomic
+//  notify_one() / notify_all() - goi sau khi da cong bo trang thai moi
+// notify chi ton syscall khi co thread dang cho.
+
+// pthread_cond: thread ngu ngay (mac dinh cua mt_queue)
+struct condvar_wait {
+    class waiter {
+        pthread_cond_t cond_;
+        pthread_mutex_t own_mutex_; // chi dung cho wait(ready) khong co mutex ngoai
+        std::atomic<int> waiters_{0};
+    public:
+        waiter() {
+            pthread_cond_init(&cond_, nullptr);
+            pthread_mutex_init(&own_mutex_, nullptr);
+        }
+
+        waiter(const waiter&) = delete;
+
+        ~waiter() {
+            pthread_cond_destroy(&cond_);
+            pthread_mutex_destroy(&own_mutex_);
+        }
+
+        template <typename Pred>
+        void wait(pthread_mutex_t& m, Pred ready) {
+            while (!ready()) {
+                waiters_.fetch_add(1, std::memory_order_relaxed);
+                check_result(pthread_cond_wait(&cond_, &m));
+                waiters_.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+
+        template <typename Pred>
+        void wait(Pred ready) {
+            while (!ready()) {
+                waiters_.fetch_add(1, std::memory_order_seq_cst);
+                check_result(pthread_mutex_lock(&own_mutex_));
+                if (!ready())
+                    check_result(pthread_cond_wait(&cond_, &own_mutex_));
+                check_result(pthread_mutex_unlock(&own_mutex_));
+                waiters_.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+
+        void notify_one() { notify(false); }
+        void notify_all() { notify(true); }
+
+    private:
+        void notify(bool all) {
+            // thu tu giua viec cong bo trang thai (truoc do) va doc waiters_ (kieu Dekker)
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (waiters_.load(std::memory_order_relaxed) == 0)
+                return;
+            check_result(pthread_mutex_lock(&own_mutex_));
+            check(all ? pthread_cond_broadcast(&cond_) : pthread_cond_signal(&cond_));
+            check_result(pthread_mutex_unlock(&own_mutex_));
+        }
+    };
+};
+
+// Spin voi pause toi da Spins vong, roi sched_yield Yields lan, roi moi ngu tren futex.
+// Adaptive: ngan sach spin bam theo so vong spin trung binh (EWMA) cua cac lan cho gan day
+// thanh cong trong pha spin; lan cho phai ngu thi giam ngan sach. Spins la tran tren.
+template <unsigned Spins = 2000, unsigned Yields = 4, bool Adaptive = false>
+struct spin_futex_wait {
+    class waiter {
+        std::atomic<uint32_t> seq_{0};     // tang moi lan notify co nguoi cho; futex nam tren tu nay
+        std::atomic<int> waiters_{0};      // dang spin hoac ngu
+        std::atomic<int> sleepers_{0};     // dang ngu tren futex
+        std::atomic<unsigned> spin_avg_{Spins / 2};
+    public:
+        waiter() = default;
+        waiter(const waiter&) = delete;
+
+        template <typename Pred>
+        void wait(pthread_mutex_t& m, Pred ready) {
+            while (!ready()) {
+                waiters_.fetch_add(1, std::memory_order_seq_cst);
+                uint32_t s = seq_.load(std::memory_order_acquire);
+                check_result(pthread_mutex_unlock(&m));
+                park(s);
+                waiters_.fetch_sub(1, std::memory_order_relaxed);
+                check_result(pthread_mutex_lock(&m));
+            }
+        }
+
+        template <typename Pred>
+        void wait(Pred ready) {
+            while (!ready()) {
+                waiters_.fetch_add(1, std::memory_order_seq_cst);
+                uint32_t s = seq_.load(std::memory_order_seq_cst);
+                if (!ready())
+                    park(s);
+                waiters_.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+
+        void notify_one() { notify(1); }
+        void notify_all() { notify(INT_MAX); }
+
+        unsigned spin_budget() const {
+            // mot CPU: thread ta cho dang chiem CPU cua ben se danh thuc, spin chi phi thoi gian
+            static const bool single_cpu = sysconf(_SC_NPROCESSORS_ONLN) <= 1;
+            if (single_cpu)
+                return 0;
+            if (!Adaptive)
+                return Spins;
+            unsigned budget = 2 * spin_avg_.load(std::memory_order_relaxed) + 16;
+            return budget < Spins ? budget : Spins;
+        }
+
+    private:
+        void notify(int n) {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (waiters_.load(std::memory_order_relaxed) == 0)
+                return;
+            seq_.fetch_add(1, std::memory_order_seq_cst);
+            if (sleepers_.load(std::memory_order_seq_cst) > 0)
+                syscall(SYS_futex, reinterpret_cast<uint32_t*>(&seq_), FUTEX_WAKE_PRIVATE, n, nullptr, nullptr, 0);
+        }
+
+        // cho den khi seq_ khac s (da co notify) hoac bi danh thuc gia
+        void park(uint32_t s) {
+            unsigned budget = spin_budget();
+            for (unsigned i = 0; i < budget; ++i) {
+                if (seq_.load(std::memory_order_acquire) != s) {
+                    adapt(i);
+                    return;
+                }
+                cpu_relax();
+            }
+            for (unsigned i = 0; i < Yields; ++i) {
+                if (seq_.load(std::memory_order_acquire) != s)
+                    return;
+                sched_yield();
+            }
+            adapt_parked();
+            sleepers_.fetch_add(1, std::memory_order_seq_cst);
+            // kernel chi cho neu seq_ van bang s, nen notify xay ra truoc do khong bi mat
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&seq_), FUTEX_WAIT_PRIVATE, s, nullptr, nullptr, 0);
+            sleepers_.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        void adapt(unsigned spins) {
+            if (Adaptive) {
+                unsigned avg = spin_avg_.load(std::memory_order_relaxed);
+                spin_avg_.store(avg + ((int)spins - (int)avg) / 8, std::memory_order_relaxed);
+            }
+        }
+
+        void adapt_parked() {
+            if (Adaptive) {
+                unsigned avg = spin_avg_.load(std::memory_order_relaxed);
+                spin_avg_.store(avg - avg / 8, std::memory_order_relaxed);
+            }
+        }
+    };
+};
+
+#endif // WAIT_POLICY_HPP
@@ -0,0 +1,145 @@
+#ifndef ZONE_MAP_HPP
+#define ZONE_MAP_HPP
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <utility>
+#include <tuple>
+#include <cmath>
+#include <cerrno>
+#include <type_traits>
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "check.hpp"
+#include "column_format.hpp"
+
+// Zone map: min/max cua tung block ZONE_BLOCK_SIZE phan tu trong file du lieu.
+// Luu canh file du lieu voi duoi ".zone" de search bo qua block khong the chua gia tri can tim.
+constexpr size_t ZONE_BLOCK_SIZE = 4096;
+constexpr uint32_t ZONE_MAGIC = 0x454e4f5a; // "ZONE"
+
+struct ZoneMapHeader {
+    uint32_t magic;
+    uint32_t block_size;
+    uint64_t element_count;
+    ElementType type;
+    uint32_t pad;
+};
+
+template <typename T>
+struct ZoneMap {
+    size_t element_count = 0;
+    std::vector<T> min;
+    std::vector<T> max;
+
+    bool empty() const { return min.empty(); }
+
+    // block co the chua phan tu nam trong [lo, hi] hay khong
+    bool may_contain(size_t block, T lo, T hi) const {
+        return max[block] >= lo && min[block] <= hi;
+    }
+};
+
+inline std::string zone_map_path(const std::string& data_path) {
+    return data_path + ".zone";
+}
+
+// Min/max cua [first, last). Voi float/double bo qua NaN (NaN khong bao gio khop khoang tim, va
+// minmax_element voi NaN dau block cho min = max = NaN); block toan NaN co min = max = NaN nen
+// may_contain luon sai: dung, vi khong phan tu nao khop
+template <typename T>
+std::pair<T, T> block_min_max(const T* first, const T* last) {
+    if constexpr (std::is_floating_point_v<T>) {
+        while (first != last && std::isnan(*first))
+            ++first;
+        if (first == last)
+            return {NAN, NAN};
+        T lo = *first, hi = *first;
+        for (++first; first != last; ++first) {
+            if (*first < lo)
+                lo = *first;
+            if (*first > hi)
+                hi = *first;
+        }
+        return {lo, hi};
+    } else {
+        auto [lo, hi] = std::minmax_element(first, last);
+        return {*lo, *hi};
+    }
+}
+
+template <typename T>
+ZoneMap<T> build_zone_map(const T* data, size_t n) {
+    ZoneMap<T> zm;
+    zm.element_count = n;
+    size_t blocks = (n + ZONE_BLOCK_SIZE - 1) / ZONE_BLOCK_SIZE;
+    zm.min.resize(blocks);
+    zm.max.resize(blocks);
+    for (size_t b = 0; b < blocks; ++b) {
+        const T* first = data + b * ZONE_BLOCK_SIZE;
+        const T* last = data + std::min(n, (b + 1) * ZONE_BLOCK_SIZE);
+        std::tie(zm.min[b], zm.max[b]) = block_min_max(first, last);
+    }
+    return zm;
+}
+
+// Zone map chi la cache: false (errno giu loi) neu khong ghi duoc, file do dang bi xoa
+template <typename T>
+bool write_zone_map(const std::string& data_path, const ZoneMap<T>& zm) {
+    std::string path = zone_map_path(data_path);
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return false;
+    ZoneMapHeader h{ZONE_MAGIC, (uint32_t)ZONE_BLOCK_SIZE, zm.element_count, element_type_of<T>(), 0};
+    size_t bytes = zm.min.size() * sizeof(T);
+    bool ok = try_pwrite_all(fd, &h, sizeof(h), 0)
+              && try_pwrite_all(fd, zm.min.data(), bytes, sizeof(h))
+              && try_pwrite_all(fd, zm.max.data(), bytes, sizeof(h) + bytes);
+    int err = errno;
+    if (close(fd) < 0 && ok) {
+        ok = false;
+        err = errno;
+    }
+    if (!ok) {
+        unlink(path.c_str());
+        errno = err;
+    }
+    return ok;
+}
+
+// Tra ve zone map rong neu khong co file .zone, file cu hon du lieu, hoac khong khop kich thuoc/kieu
+template <typename T>
+ZoneMap<T> load_zone_map(const std::string& data_path, size_t element_count) {
+    ZoneMap<T> zm;
+    struct stat data_st{}, zone_st{};
+    if (stat(data_path.c_str(), &data_st) < 0 || stat(zone_map_path(data_path).c_str(), &zone_st) < 0)
+        return zm;
+    if (zone_st.st_mtim.tv_sec < data_st.st_mtim.tv_sec
+        || (zone_st.st_mtim.tv_sec == data_st.st_mtim.tv_sec && zone_st.st_mtim.tv_nsec < data_st.st_mtim.tv_nsec))
+        return zm;
+
+    int fd = open(zone_map_path(data_path).c_str(), O_RDONLY);
+    if (fd < 0)
+        return zm;
+    ZoneMapHeader h{};
+    size_t blocks = (element_count + ZONE_BLOCK_SIZE - 1) / ZONE_BLOCK_SIZE;
+    size_t bytes = blocks * sizeof(T);
+    if (read(fd, &h, sizeof(h)) == (ssize_t)sizeof(h) && h.magic == ZONE_MAGIC
+        && h.block_size == ZONE_BLOCK_SIZE && h.element_count == element_count && h.type == element_type_of<T>()) {
+        zm.min.resize(blocks);
+        zm.max.resize(blocks);
+        if (read(fd, zm.min.data(), bytes) != (ssize_t)bytes || read(fd, zm.max.data(), bytes) != (ssize_t)bytes) {
+            zm.min.clear();
+            zm.max.clear();
+        } else {
+            zm.element_count = element_count;
+        }
+    }
+    close(fd);
+    return zm;
+}
+
+#endif // ZONE_MAP_HPP
@@ -0,0 +1,183 @@
+#ifndef EPOLL_SERVER_HPP
+#define EPOLL_SERVER_HPP
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include "check.hpp"
+#include "game.hpp"
+
+// Backend mot process, mot thread: socket non-blocking, epoll edge-triggered. Trang thai moi
+// ket noi (so bi mat, phan frame 4 byte da nhan, phan tra loi chua gui) nam trong bang
+// danh chi so theo fd thay vi trong mot process con. Moi fd duoc dang ky mot lan voi
+// EPOLLIN | EPOLLOUT | EPOLLET: moi su kien doc den EAGAIN roi gui den EAGAIN.
+class epoll_server {
+public:
+    static constexpr int MAX_EVENTS = 1024;
+    static constexpr size_t READ_BUFFER = 64 * 1024;
+    static constexpr size_t MAX_PENDING_OUT = 64 * 1024; // client khong doc tra loi: ngung doc cua no
+
+    explicit epoll_server(int listen_fd)
+        : listen_fd_(listen_fd), buffer_(READ_BUFFER) {
+        set_nonblocking(listen_fd_);
+        epfd_ = check(epoll_create1(EPOLL_CLOEXEC));
+        spare_fd_ = check(open("/dev/null", O_RDONLY | O_CLOEXEC));
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLET;
+        ev.data.fd = listen_fd_;
+        check(epoll_ctl(epfd_, EPOLL_CTL_ADD, listen_fd_, &ev));
+    }
+
+    epoll_server(const epoll_server&) = delete;
+
+    ~epoll_server() {
+        for (size_t fd = 0; fd < conns_.size(); ++fd)
+            if (conns_[fd].open)
+                close(fd);
+        close(spare_fd_);
+        close(epfd_);
+    }
+
+    [[noreturn]] void run() {
+        epoll_event events[MAX_EVENTS];
+        while (true) {
+            int n = check_except(epoll_wait(epfd_, events, MAX_EVENTS, -1), EINTR);
+            for (int i = 0; i < n; ++i) {
+                int fd = events[i].data.fd;
+                if (fd == listen_fd_)
+                    accept_all();
+                else
+                    handle(fd);
+            }
+        }
+    }
+
+    static void set_nonblocking(int fd) {
+        int flags = check(fcntl(fd, F_GETFL));
+        check(fcntl(fd, F_SETFL, flags | O_NONBLOCK));
+    }
+
+private:
+    struct connection {
+        bool open = false;
+        game_session game;  // game.done: dong sau khi gui het tra loi
+        sockaddr_in addr{};
+        std::string out;    // tra loi chua gui
+        size_t out_sent = 0;
+        bool read_closed = false; // client da dong chieu gui (EOF): chi con gui not tra loi
+    };
+
+    enum class read_status { again, paused, eof, error };
+
+    int listen_fd_;
+    int epfd_;
+    int spare_fd_; // giu san mot fd: het fd (EMFILE) thi nha ra de accept roi dong ket noi
+    std::vector<connection> conns_; // chi so la fd
+    std::vector<char> buffer_;
+
+    void accept_all() {
+        while (true) {
+            sockaddr_in addr{};
+            socklen_t len = sizeof(addr);
+            int fd = accept4(listen_fd_, (sockaddr*)&addr, &len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    return;
+                if (errno == EINTR || errno == ECONNABORTED || errno == EPROTO)
+                    continue;
+                if (errno == EMFILE || errno == ENFILE) {
+                    // edge-triggered: ket noi dang cho khong bao lai nua, phai lay ra khoi hang doi
+                    close(spare_fd_);
+                    int rejected = accept(listen_fd_, nullptr, nullptr);
+                    if (rejected >= 0)
+                        close(rejected);
+                    spare_fd_ = check(open("/dev/null", O_RDONLY | O_CLOEXEC));
+                    log_event("Too many open files: connection rejected");
+                    continue;
+                }
+                check(fd);
+            }
+            if ((size_t)fd >= conns_.size())
+                conns_.resize(fd + 1);
+            connection& c = conns_[fd];
+            c.open = true;
+            c.game.reset();
+            c.addr = addr;
+            c.out.clear();
+            c.out_sent = 0;
+            c.read_closed = false;
+
+            epoll_event ev{};
+            ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+            ev.data.fd = fd;
+            check(epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &ev));
+            log_event("Connected: " + addr_to_str(addr));
+        }
+    }
+
+    void handle(int fd) {
+        connection& c = conns_[fd];
+        if (!c.open)
+            return; // da dong o su kien truoc trong cung dot
+        while (true) {
+            read_status r = c.read_closed ? read_status::eof : read_some(fd, c);
+            c.read_closed = r == read_status::eof;
+            // EOF (vd shutdown(SHUT_WR)): ngung doc nhung van gui het tra loi, cho EPOLLOUT neu can
+            if (r == read_status::error || !flush(fd, c)
+                || ((c.game.done || c.read_closed) && c.out_sent == c.out.size())) {
+                close_connection(fd, c);
+                return;
+            }
+            // ngung doc vi tra loi don lai: gui het roi thi doc tiep, neu khong cho EPOLLOUT
+            if (r != read_status::paused || c.out_sent != c.out.size())
+                return;
+        }
+    }
+
+    read_status read_some(int fd, connection& c) {
+        while (c.out.size() - c.out_sent < MAX_PENDING_OUT) {
+            ssize_t n = recv(fd, buffer_.data(), buffer_.size(), 0);
+            if (n > 0) {
+                c.game.feed(buffer_.data(), n, c.addr, c.out);
+                continue;
+            }
+            if (n == 0)
+                return read_status::eof;
+            if (errno == EINTR)
+                continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK ? read_status::again : read_status::error;
+        }
+        return read_status::paused;
+    }
+
+    // false neu ket noi loi
+    bool flush(int fd, connection& c) {
+        while (c.out_sent < c.out.size()) {
+            ssize_t n = send(fd, c.out.data() + c.out_sent, c.out.size() - c.out_sent, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                return errno == EAGAIN || errno == EWOULDBLOCK; // cho EPOLLOUT
+            }
+            c.out_sent += n;
+        }
+        c.out.clear();
+        c.out_sent = 0;
+        return true;
+    }
+
+    void close_connection(int fd, connection& c) {
+        c.open = false;
+        c.out.clear();
+        c.out.shrink_to_fit();
+        close(fd); // tu go khoi epoll
+        log_event("Disconnected: " + addr_to_str(c.addr));
+    }
+};
+
+#endif // EPOLL_SERVER_HPP
@@ -0,0 +1,90 @@
+#ifndef GAME_HPP
+#define GAME_HPP
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <random>
+#include "async_log.hpp"
+
+// Logic tro choi doan so dung chung cho moi backend cua server.
+// Giao thuc: client gui int (4 byte) la so doan, server tra int: -1 nho qua, 1 lon qua, 0 dung.
+// Doan dung thi server dong ket noi.
+
+constexpr int SECRET_MIN = 1;
+constexpr int SECRET_MAX = 100;
+constexpr size_t FRAME_SIZE = sizeof(int);
+
+// Ghi log qua async_logger (lab3): khong khoa file, khong flush moi dong
+inline void log_event(const std::string& msg) {
+    async_logger::instance().logf("[LOG] %s", msg.c_str());
+}
+
+inline std::string addr_to_str(const sockaddr_in& addr) {
+    char ip[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip));
+    return std::string(ip) + ":" + std::to_string(ntohs(addr.sin_port));
+}
+
+// Moi thread mot bo sinh, chi goi random_device mot lan. Process con sau fork co ban sao
+// trang thai cua cha nen so bi mat phai duoc sinh o process cha.
+inline int new_secret() {
+    thread_local std::mt19937 gen(std::random_device{}());
+    std::uniform_int_distribution<> dis(SECRET_MIN, SECRET_MAX);
+    int secret = dis(gen);
+    async_logger::instance().logf("secret: %d", secret);
+    return secret;
+}
+
+inline int judge(int guess, int secret) {
+    if (guess < secret)
+        return -1; // "Too low"
+    if (guess > secret)
+        return 1;  // "Too high"
+    return 0;      // "Correct!"
+}
+
+inline void log_guess(const std::string& addr, int guess, int response) {
+    async_logger::instance().logf("[LOG] %s guessed %d -> %s", addr.c_str(), guess,
+                                  response == 0 ? "Correct!" : (response < 0 ? "Too low" : "Too high"));
+}
+
+// Trang thai giao thuc cua mot ket noi non-blocking: du lieu den theo doan bat ky, frame 4 byte
+// co the bi cat o bat ky byte nao. Tra loi duoc them vao out de gui theo dot.
+struct game_session {
+    int secret = 0;
+    bool done = false;  // da doan dung: du lieu sau do bi bo qua
+    uint8_t in_len = 0; // so byte cua frame dang nhan do
+    unsigned char in[FRAME_SIZE];
+
+    void reset() {
+        secret = new_secret();
+        done = false;
+        in_len = 0;
+    }
+
+    void feed(const char* data, size_t size, const sockaddr_in& peer, std::string& out) {
+        std::string addr;
+        for (size_t i = 0; i < size && !done; ) {
+            size_t take = std::min(FRAME_SIZE - in_len, size - i);
+            memcpy(in + in_len, data + i, take);
+            in_len += take;
+            i += take;
+            if (in_len < FRAME_SIZE)
+                break;
+            in_len = 0;
+            int guess;
+            memcpy(&guess, in, sizeof(guess));
+            int response = judge(guess, secret);
+            out.append((const char*)&response, sizeof(response));
+            if (addr.empty())
+                addr = addr_to_str(peer);
+            log_guess(addr, guess, response);
+            done = response == 0;
+        }
+    }
+};
+
+#endif // GAME_HPP
@@ -2,61 +2,33 @@
 #include <unistd.h>
 #include <sys/socket.h>
 #include <sys/wait.h>
-#include <sys/file.h>
+#include <sys/resource.h>
+#include <sys/prctl.h>
 #include <fcntl.h>
 #include <signal.h>
-#include <cstdlib>
+#include <pthread.h>
 #include <ctime>
-#include <iostream>
+#include <cstdlib>
+#include <cstring>
 #include <string>
-#include <random>
+#include <vector>
 #include "check.hpp"
+#include "game.hpp"
+#include "epoll_server.hpp"
+#include "uring_server.hpp"
 
 #define PORT 60002
-#define MAX_CLIENTS 10
-#define BUFFER_SIZE 1024
-
-void log_sync(const std::string& msg) {
-    flock(1, LOCK_EX);
-    std::cout << "[LOG] " << msg << std::endl;
-    flock(1, LOCK_UN);
-}
-
-std::string addr_to_str(const sockaddr_in& addr) {
-    char ip[INET_ADDRSTRLEN];
-    inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip));
-    return std::string(ip) + ":" + std::to_string(ntohs(addr.sin_port));
-}
-
-void handle_client(int client_sock, sockaddr_in client_addr) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(1, 100);
-    int secret = dis(gen);
-    std::cout << "secret: " << secret << std::endl;
-
-    std::string addr = addr_to_str(client_addr);
+#define BACKLOG SOMAXCONN
 
+void handle_client(int client_sock, int secret, const std::string& addr) {
     while (true) {
         int guess;
-        int bytes = recv(client_sock, &guess, sizeof(guess), 0);
-        if (bytes <= 0) break;
-//        buffer[bytes] = '\0';
-//        std::string guess_str(buffer);
-//        int guess;
-
-        int response;
-        if (guess < secret)
-            response = -1; //"Too low"; // -1
-        else if (guess > secret)
-            response = 1; // "Too high"; // 1
-        else {
-            response = 0; //"Correct!"; // 0
-        }
+        int bytes = recv(client_sock, &guess, sizeof(guess), MSG_WAITALL);
+        if (bytes < (int)sizeof(guess)) break;
 
-        send(client_sock, &response, sizeof(response), 0);
-        log_sync(addr + " guessed " + std::to_string(guess) + " -> " +
-                    (response == 0 ? "Correct!" : (response < 0 ? "Too low" : "Too high")));
+        int response = judge(guess, secret);
+        send(client_sock, &response, sizeof(response), MSG_NOSIGNAL);
+        log_guess(addr, guess, response);
         if (response == 0)
             break;
     }
@@ -68,41 +40,191 @@ void zombie_ignore() {
     sigaction(SIGCHLD, &sa, nullptr);
 }
 
-int main() {
-    int server_fd = check(socket(AF_INET, SOCK_STREAM, 0));
-
-    sockaddr_in server_addr{};
-    server_addr.sin_family = AF_INET; //IPv4 address family internet
-    server_addr.sin_port = htons(PORT);  //network byte order
-    server_addr.sin_addr.s_addr = INADDR_ANY; //cho phep server nhan ket noi tu moi IP
-
-    check(bind(server_fd, (sockaddr*)&server_addr, sizeof(server_addr)));
-    check(listen(server_fd, MAX_CLIENTS) );
-
+// Backend cu: moi ket noi mot process con
+[[noreturn]] void run_fork_server(int server_fd) {
     zombie_ignore();
-    log_sync("Server listening on port " + std::to_string(PORT));
-
     while (true) {
         sockaddr_in client_addr{};
         socklen_t client_len = sizeof(client_addr);
 
-        int client_fd = check(accept(server_fd, (sockaddr*)&client_addr, &client_len));
+        int client_fd = check_except(accept(server_fd, (sockaddr*)&client_addr, &client_len), EINTR, ECONNABORTED);
+        if (client_fd < 0)
+            continue;
 
         std::string client_info = addr_to_str(client_addr);
-        log_sync("Connected: " + client_info);
+        log_event("Connected: " + client_info);
+        int secret = new_secret(); // sinh o process cha: con co cung trang thai bo sinh
 
         pid_t pid = fork();
         if (pid == 0) { // child
             close(server_fd);
-            handle_client(client_fd, client_addr);
+            handle_client(client_fd, secret, client_info);
             close(client_fd);
-            log_sync("Disconnected: " + client_info);
+            log_event("Disconnected: " + client_info);
             exit(0);
         } else if (pid > 0) {
             close(client_fd); // parent đóng socket dùng bởi child
         } else {
             perror("fork");
+            close(client_fd);
         }
     }
 }
 
+// Moi ket noi la mot fd: nang gioi han mem len gioi han cung
+void raise_fd_limit() {
+    rlimit rl{};
+    check(getrlimit(RLIMIT_NOFILE, &rl));
+    rl.rlim_cur = rl.rlim_max;
+    check(setrlimit(RLIMIT_NOFILE, &rl));
+}
+
+// Socket nghe tren PORT. reuseport: nhieu socket cung cong, kernel chia ket noi giua chung
+int make_listener(bool reuseport) {
+    int fd = check(socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0));
+    int one = 1;
+    check(setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)));
+    if (reuseport)
+        check(setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)));
+
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET; //IPv4 address family internet
+    server_addr.sin_port = htons(PORT);  //network byte order
+    server_addr.sin_addr.s_addr = INADDR_ANY; //cho phep server nhan ket noi tu moi IP
+
+    check(bind(fd, (sockaddr*)&server_addr, sizeof(server_addr)));
+    check(listen(fd, BACKLOG));
+    return fd;
+}
+
+// Vong lap su kien tao ngay trong thread chay no (ring io_uring SINGLE_ISSUER gan voi thread tao)
+[[noreturn]] void run_event_loop(const std::string& backend, int listen_fd) {
+    if (backend == "uring")
+        uring_server(listen_fd).run();
+    epoll_server(listen_fd).run();
+}
+
+struct event_loop_args {
+    std::string backend;
+    int listen_fd;
+};
+
+void* event_loop_thread(void* arg) {
+    auto* a = (event_loop_args*)arg;
+    run_event_loop(a->backend, a->listen_fd);
+}
+
+// Moi socket mot vong lap: them thread cho tat ca tru socket cuoi, socket cuoi chay o thread goi
+[[noreturn]] void run_event_loops(const std::string& backend, const std::vector<int>& listeners) {
+    for (size_t i = 0; i + 1 < listeners.size(); ++i) {
+        pthread_t t;
+        check_result(pthread_create(&t, nullptr, event_loop_thread, new event_loop_args{backend, listeners[i]}));
+        check_result(pthread_detach(t));
+    }
+    run_event_loop(backend, listeners.back());
+}
+
+// Pool process: listeners duoc tao truoc o process cha, worker k dung listeners[k*threads, (k+1)*threads).
+// Worker chet thi sinh lai voi dung cac socket do: ket noi dang cho trong hang doi accept cua
+// chung khong bi mat (dong mot socket SO_REUSEPORT se reset cac ket noi dang cho cua no).
+[[noreturn]] void supervise(const std::string& backend, const std::vector<int>& listeners, int workers) {
+    constexpr time_t MIN_UPTIME = 1; // worker chet som hon: cho truoc khi sinh lai, tranh vong fork lien tuc
+    constexpr useconds_t RETRY_US = 100000; // chu ky kiem tra khi co slot dang cho sinh lai
+    size_t threads = listeners.size() / workers;
+    std::vector<pid_t> pids(workers, -1);      // -1: slot trong
+    std::vector<time_t> started(workers);
+    std::vector<time_t> not_before(workers, 0); // slot trong khong duoc sinh lai truoc luc nay
+    pid_t supervisor = getpid();
+
+    auto spawn = [&](int k) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            prctl(PR_SET_PDEATHSIG, SIGTERM); // supervisor chet thi worker cung dung
+            if (getppid() != supervisor)
+                _exit(1);
+            std::vector<int> own(listeners.begin() + k * threads, listeners.begin() + (k + 1) * threads);
+            for (size_t i = 0; i < listeners.size(); ++i)
+                if (i / threads != (size_t)k)
+                    close(listeners[i]);
+            run_event_loops(backend, own);
+        }
+        if (pid < 0) {
+            perror("fork");
+            not_before[k] = time(nullptr) + MIN_UPTIME;
+            return;
+        }
+        pids[k] = pid;
+        started[k] = time(nullptr);
+        log_event("Worker " + std::to_string(k) + " started (pid " + std::to_string(pid) + ")");
+    };
+
+    // Moi vong: sinh lai moi slot trong da den han, roi reap. Con slot dang cho thi waitpid khong
+    // chan (WNOHANG) de vua reap worker khac vua thu lai dung han; khong con thi chan den khi co worker chet
+    while (true) {
+        time_t now = time(nullptr);
+        bool pending = false;
+        for (int k = 0; k < workers; ++k) {
+            if (pids[k] < 0 && now >= not_before[k])
+                spawn(k);
+            pending = pending || pids[k] < 0;
+        }
+        int status;
+        pid_t pid = check_except(waitpid(-1, &status, pending ? WNOHANG : 0), EINTR, ECHILD);
+        if (pid <= 0) {
+            if (pending)
+                usleep(RETRY_US);
+            continue;
+        }
+        for (int k = 0; k < workers; ++k) {
+            if (pids[k] != pid)
+                continue;
+            std::string how = WIFSIGNALED(status) ? "killed by signal " + std::to_string(WTERMSIG(status))
+                                                  : "exited with status " + std::to_string(WEXITSTATUS(status));
+            log_event("Worker " + std::to_string(k) + " (pid " + std::to_string(pid) + ") " + how + ", respawning");
+            pids[k] = -1;
+            not_before[k] = started[k] + MIN_UPTIME; // chet som: doi du MIN_UPTIME ke tu luc sinh
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string backend = "epoll";
+    int workers = 0; // 0: khong co process con, process nay chay vong lap su kien
+    int threads = 1; // so vong lap su kien moi process
+    bool ok = true;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--backend") == 0 && i + 1 < argc)
+            backend = argv[++i];
+        else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc)
+            workers = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else
+            ok = false;
+    }
+    if (backend != "epoll" && backend != "uring" && backend != "fork")
+        ok = false;
+    if (workers < 0 || threads < 1 || (backend == "fork" && (workers > 0 || threads > 1)))
+        ok = false;
+    if (!ok) {
+        fprintf(stderr, "Usage: ./server [--backend epoll|uring|fork] [--workers N] [--threads N]\n");
+        return 1;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    raise_fd_limit();
+
+    size_t loops = (size_t)std::max(workers, 1) * threads;
+    std::vector<int> listeners;
+    for (size_t i = 0; i < loops; ++i)
+        listeners.push_back(make_listener(loops > 1));
+
+    log_event("Server listening on port " + std::to_string(PORT) + " (" + backend + ", "
+              + std::to_string(workers) + " workers x " + std::to_string(threads) + " threads)");
+
+    if (backend == "fork")
+        run_fork_server(listeners[0]);
+    if (workers > 0)
+        supervise(backend, listeners, workers);
+    run_event_loops(backend, listeners);
+}
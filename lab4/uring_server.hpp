@@ -0,0 +1,379 @@
+#ifndef URING_SERVER_HPP
+#define URING_SERVER_HPP
+
+#include <atomic>
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include "check.hpp"
+#include "game.hpp"
+
+// Backend io_uring goi thang syscall (khong dung liburing). Mot thread, mot ring:
+//  - accept multishot: mot SQE nhan moi ket noi
+//  - recv multishot voi provided buffer ring: kernel tu chon buffer, ta tra buffer ve ring
+//    ngay sau khi doc, khong can SQE moi cho moi lan nhan
+//  - send: moi ket noi toi da mot send dang chay (giu thu tu); tra loi cuoi cung duoc noi
+//    (IOSQE_IO_LINK) voi shutdown de ket thuc recv ngay khi gui xong
+// Moi vong lap chi mot io_uring_enter vua nop SQE vua cho CQE, nen duoi tai mot lan
+// syscall phuc vu nhieu luot hoi/dap.
+class uring_server {
+public:
+    static constexpr unsigned SQ_ENTRIES = 4096;
+    static constexpr unsigned CQ_ENTRIES = 16384;
+    static constexpr unsigned BUFFERS = 4096; // luy thua cua 2
+    static constexpr unsigned BUFFER_SIZE = 1024;
+    static constexpr uint16_t BUFFER_GROUP = 0;
+
+    explicit uring_server(int listen_fd) : listen_fd_(listen_fd) {
+        setup_ring();
+        setup_buffers();
+        submit_accept();
+    }
+
+    uring_server(const uring_server&) = delete;
+
+    ~uring_server() {
+        for (size_t fd = 0; fd < conns_.size(); ++fd)
+            if (conns_[fd].open)
+                close(fd);
+        munmap(buf_ring_, BUFFERS * sizeof(io_uring_buf));
+        munmap(sqes_, sq_entries_ * sizeof(io_uring_sqe));
+        if (cq_ptr_ != sq_ptr_)
+            munmap(cq_ptr_, cq_size_);
+        munmap(sq_ptr_, sq_size_);
+        close(ring_fd_);
+    }
+
+    [[noreturn]] void run() {
+        while (true) {
+            submit(1);
+            unsigned head = *cq_head_;
+            unsigned tail = std::atomic_ref<unsigned>(*cq_tail_).load(std::memory_order_acquire);
+            for (; head != tail; ++head) {
+                // moi CQE co the can toi MAX_SQES_PER_EVENT SQE: nop truoc neu SQ sap day
+                if (sq_free() < MAX_SQES_PER_EVENT && (submit(0), sq_free() < MAX_SQES_PER_EVENT))
+                    break; // kernel chua nhan (CQ tran): giai phong CQ roi thu lai
+                handle(cqes_[head & cq_mask_]);
+            }
+            std::atomic_ref<unsigned>(*cq_head_).store(head, std::memory_order_release);
+        }
+    }
+
+private:
+    enum op : uint8_t { OP_ACCEPT, OP_RECV, OP_SEND, OP_SHUTDOWN, OP_CLOSE };
+
+    static constexpr unsigned MAX_SQES_PER_EVENT = 4;
+
+    struct connection {
+        uint32_t gen = 0;         // tang moi lan fd duoc dung lai: bo qua CQE cu
+        bool open = false;
+        bool recv_active = false; // recv multishot con dang chay
+        bool send_linked = false; // send dang chay co shutdown noi sau
+        bool shutdown = false;    // da nop shutdown
+        game_session game;
+        sockaddr_in addr{};
+        std::string out;     // tra loi cho gui
+        std::string sending; // kernel dang doc tu day: khong duoc sua den khi send xong
+    };
+
+    int listen_fd_;
+    int ring_fd_ = -1;
+    void* sq_ptr_ = nullptr;
+    void* cq_ptr_ = nullptr;
+    size_t sq_size_ = 0, cq_size_ = 0;
+    unsigned sq_entries_ = 0;
+    unsigned* sq_head_;
+    unsigned* sq_tail_;
+    unsigned sq_mask_;
+    io_uring_sqe* sqes_;
+    unsigned sq_local_tail_ = 0; // SQE da dien
+    unsigned sq_submitted_ = 0;  // SQE da nop cho kernel
+    unsigned* cq_head_;
+    unsigned* cq_tail_;
+    unsigned cq_mask_;
+    io_uring_cqe* cqes_;
+    io_uring_buf_ring* buf_ring_ = nullptr;
+    std::unique_ptr<char[]> buffers_;
+    uint16_t buf_tail_ = 0;
+    std::vector<connection> conns_; // chi so la fd
+
+    static int sys_setup(unsigned entries, io_uring_params* p) {
+        return (int)syscall(__NR_io_uring_setup, entries, p);
+    }
+
+    static int sys_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+        return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0);
+    }
+
+    static int sys_register(int fd, unsigned opcode, void* arg, unsigned nr_args) {
+        return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+    }
+
+    static void* map_ring(size_t size, int fd, off_t offset) {
+        void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+        if (p == MAP_FAILED)
+            check(-1);
+        return p;
+    }
+
+    void setup_ring() {
+        // SINGLE_ISSUER + DEFER_TASKRUN: kernel chi xu ly hoan tat khi ta goi enter (it ngat quang hon);
+        // kernel cu (< 6.1) khong co thi dung cau hinh thuong
+        io_uring_params p{};
+        p.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+        p.cq_entries = CQ_ENTRIES;
+        ring_fd_ = sys_setup(SQ_ENTRIES, &p);
+        if (ring_fd_ < 0 && errno == EINVAL) {
+            p = {};
+            p.flags = IORING_SETUP_CQSIZE;
+            p.cq_entries = CQ_ENTRIES;
+            ring_fd_ = sys_setup(SQ_ENTRIES, &p);
+        }
+        check(ring_fd_);
+
+        sq_entries_ = p.sq_entries;
+        sq_size_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cq_size_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        if (p.features & IORING_FEAT_SINGLE_MMAP) {
+            sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+            sq_ptr_ = cq_ptr_ = map_ring(sq_size_, ring_fd_, IORING_OFF_SQ_RING);
+        } else {
+            sq_ptr_ = map_ring(sq_size_, ring_fd_, IORING_OFF_SQ_RING);
+            cq_ptr_ = map_ring(cq_size_, ring_fd_, IORING_OFF_CQ_RING);
+        }
+        sqes_ = (io_uring_sqe*)map_ring(p.sq_entries * sizeof(io_uring_sqe), ring_fd_, IORING_OFF_SQES);
+
+        char* sq = (char*)sq_ptr_;
+        sq_head_ = (unsigned*)(sq + p.sq_off.head);
+        sq_tail_ = (unsigned*)(sq + p.sq_off.tail);
+        sq_mask_ = *(unsigned*)(sq + p.sq_off.ring_mask);
+        unsigned* array = (unsigned*)(sq + p.sq_off.array);
+        for (unsigned i = 0; i < p.sq_entries; ++i)
+            array[i] = i; // SQE dung theo dung thu tu vong: chi so co dinh
+        sq_local_tail_ = sq_submitted_ = *sq_tail_;
+
+        char* cq = (char*)cq_ptr_;
+        cq_head_ = (unsigned*)(cq + p.cq_off.head);
+        cq_tail_ = (unsigned*)(cq + p.cq_off.tail);
+        cq_mask_ = *(unsigned*)(cq + p.cq_off.ring_mask);
+        cqes_ = (io_uring_cqe*)(cq + p.cq_off.cqes);
+    }
+
+    void setup_buffers() {
+        void* ring = mmap(nullptr, BUFFERS * sizeof(io_uring_buf), PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ring == MAP_FAILED)
+            check(-1);
+        buf_ring_ = (io_uring_buf_ring*)ring;
+        io_uring_buf_reg reg{};
+        reg.ring_addr = (uint64_t)buf_ring_;
+        reg.ring_entries = BUFFERS;
+        reg.bgid = BUFFER_GROUP;
+        check(sys_register(ring_fd_, IORING_REGISTER_PBUF_RING, &reg, 1));
+        buffers_.reset(new char[(size_t)BUFFERS * BUFFER_SIZE]);
+        for (unsigned bid = 0; bid < BUFFERS; ++bid)
+            recycle(bid);
+    }
+
+    // Tra buffer ve ring cho kernel dung lai. Khong dung buf_ring_->bufs: trong C++ struct rong
+    // cua __DECLARE_FLEX_ARRAY chiem cho, bufs lech 8 byte so voi kernel
+    void recycle(unsigned bid) {
+        io_uring_buf& b = ((io_uring_buf*)buf_ring_)[buf_tail_ & (BUFFERS - 1)];
+        b.addr = (uint64_t)(buffers_.get() + (size_t)bid * BUFFER_SIZE);
+        b.len = BUFFER_SIZE;
+        b.bid = bid;
+        ++buf_tail_;
+        std::atomic_ref<uint16_t>(buf_ring_->tail).store(buf_tail_, std::memory_order_release);
+    }
+
+    unsigned sq_free() const {
+        return sq_entries_ - (sq_local_tail_ - std::atomic_ref<unsigned>(*sq_head_).load(std::memory_order_acquire));
+    }
+
+    // Goi sau khi da chac con cho (vong lap run() giu it nhat MAX_SQES_PER_EVENT o trong)
+    io_uring_sqe* get_sqe(uint8_t opcode, int fd, uint64_t user_data) {
+        io_uring_sqe* sqe = &sqes_[sq_local_tail_++ & sq_mask_];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = opcode;
+        sqe->fd = fd;
+        sqe->user_data = user_data;
+        return sqe;
+    }
+
+    // Nop SQE da dien va cho it nhat wait CQE (mot syscall)
+    void submit(unsigned wait) {
+        std::atomic_ref<unsigned>(*sq_tail_).store(sq_local_tail_, std::memory_order_release);
+        unsigned pending = sq_local_tail_ - sq_submitted_;
+        if (pending == 0 && wait == 0)
+            return;
+        int n = sys_enter(ring_fd_, pending, wait, wait ? IORING_ENTER_GETEVENTS : 0);
+        if (n < 0) {
+            if (errno == EINTR || errno == EBUSY || errno == EAGAIN)
+                return; // SQE van nam trong SQ, nop lai o vong sau
+            check(n);
+        }
+        sq_submitted_ += n;
+    }
+
+    static uint64_t pack(op o, int fd, uint32_t gen) {
+        return (uint64_t)gen << 32 | (uint64_t)(uint32_t)fd << 8 | o;
+    }
+
+    void submit_accept() {
+        io_uring_sqe* sqe = get_sqe(IORING_OP_ACCEPT, listen_fd_, pack(OP_ACCEPT, listen_fd_, 0));
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        sqe->accept_flags = SOCK_CLOEXEC;
+    }
+
+    void submit_recv(int fd, connection& c) {
+        io_uring_sqe* sqe = get_sqe(IORING_OP_RECV, fd, pack(OP_RECV, fd, c.gen));
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = BUFFER_GROUP;
+        c.recv_active = true;
+    }
+
+    void submit_shutdown(int fd, connection& c, bool linked_to_send) {
+        if (!linked_to_send && c.shutdown)
+            return;
+        io_uring_sqe* sqe = get_sqe(IORING_OP_SHUTDOWN, fd, pack(OP_SHUTDOWN, fd, c.gen));
+        sqe->len = SHUT_RDWR;
+        c.shutdown = true;
+    }
+
+    // Mot send moi lan cho moi ket noi; send chua tra loi cuoi noi voi shutdown
+    void start_send(int fd, connection& c) {
+        if (!c.sending.empty() || c.out.empty())
+            return;
+        c.sending.swap(c.out);
+        c.send_linked = c.game.done; // khong con tra loi nao sau lan nay
+        submit_send(fd, c);
+    }
+
+    void submit_send(int fd, connection& c) {
+        io_uring_sqe* sqe = get_sqe(IORING_OP_SEND, fd, pack(OP_SEND, fd, c.gen));
+        sqe->addr = (uint64_t)c.sending.data();
+        sqe->len = c.sending.size();
+        sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL; // gui thieu van co the xay ra: link bi cat, gui lai phan con
+        if (c.send_linked) {
+            sqe->flags = IOSQE_IO_LINK;
+            submit_shutdown(fd, c, true);
+        }
+    }
+
+    // Tra loi cuoi da gui xong (hoac ket noi hong) ma khong con shutdown nao dang cho
+    void maybe_shutdown(int fd, connection& c) {
+        if (c.open && c.game.done && c.sending.empty() && c.out.empty() && !c.shutdown)
+            submit_shutdown(fd, c, false);
+    }
+
+    // Dong khi recv da ket thuc va khong con send dang chay
+    void maybe_close(int fd, connection& c) {
+        if (!c.open || c.recv_active || !c.sending.empty())
+            return;
+        c.open = false;
+        log_event("Disconnected: " + addr_to_str(c.addr));
+        get_sqe(IORING_OP_CLOSE, fd, pack(OP_CLOSE, fd, c.gen));
+    }
+
+    void handle(const io_uring_cqe& cqe) {
+        op o = (op)(cqe.user_data & 0xff);
+        int fd = (int)(uint32_t)(cqe.user_data >> 8 & 0xffffff);
+        uint32_t gen = cqe.user_data >> 32;
+        if (o == OP_ACCEPT) {
+            on_accept(cqe);
+            return;
+        }
+        connection& c = conns_[fd];
+        if (c.gen != gen)
+            return; // CQE cua ket noi cu cung fd
+        switch (o) {
+            case OP_RECV: on_recv(fd, c, cqe); break;
+            case OP_SEND: on_send(fd, c, cqe.res); break;
+            case OP_SHUTDOWN:
+                // send noi truoc bi loi hoac gui thieu; dang gui lai phan con thi link moi lo shutdown
+                if (cqe.res == -ECANCELED && c.sending.empty()) {
+                    c.shutdown = false;
+                    maybe_shutdown(fd, c);
+                }
+                break;
+            default: break;
+        }
+    }
+
+    void on_accept(const io_uring_cqe& cqe) {
+        if (!(cqe.flags & IORING_CQE_F_MORE))
+            submit_accept(); // multishot da dung (vd loi): nop lai
+        if (cqe.res < 0) {
+            if (cqe.res != -ECONNABORTED && cqe.res != -EINTR)
+                log_event(std::string("accept: ") + strerror(-cqe.res));
+            return;
+        }
+        int fd = cqe.res;
+        if ((size_t)fd >= conns_.size())
+            conns_.resize(fd + 1);
+        connection& c = conns_[fd];
+        ++c.gen;
+        c.open = true;
+        c.shutdown = false;
+        c.send_linked = false;
+        c.game.reset();
+        c.out.clear();
+        c.sending.clear();
+        socklen_t len = sizeof(c.addr);
+        if (getpeername(fd, (sockaddr*)&c.addr, &len) < 0)
+            c.addr = {};
+        log_event("Connected: " + addr_to_str(c.addr));
+        submit_recv(fd, c);
+    }
+
+    void on_recv(int fd, connection& c, const io_uring_cqe& cqe) {
+        bool more = cqe.flags & IORING_CQE_F_MORE;
+        if (cqe.res > 0) {
+            unsigned bid = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+            c.game.feed(buffers_.get() + (size_t)bid * BUFFER_SIZE, cqe.res, c.addr, c.out);
+            recycle(bid);
+            start_send(fd, c);
+            if (!more)
+                submit_recv(fd, c);
+            return;
+        }
+        if (cqe.res == -ENOBUFS && !c.shutdown) { // het buffer luc do: buffer da duoc tra, nop lai
+            submit_recv(fd, c);
+            return;
+        }
+        if (!more) { // EOF, loi, hoac shutdown sau tra loi cuoi
+            c.recv_active = false;
+            maybe_close(fd, c);
+        }
+    }
+
+    void on_send(int fd, connection& c, int res) {
+        if (res >= 0 && (size_t)res < c.sending.size()) { // gui thieu: gui tiep phan con, giu thu tu frame
+            c.sending.erase(0, res);
+            submit_send(fd, c);
+            return;
+        }
+        c.sending.clear();
+        if (res < 0) { // ket noi hong: bo tra loi, ket thuc recv de dong
+            c.out.clear();
+            c.game.done = true;
+            if (c.send_linked)
+                c.shutdown = false; // shutdown noi sau send nay chac chan bi huy
+            maybe_shutdown(fd, c);
+        } else {
+            start_send(fd, c);
+        }
+        maybe_close(fd, c);
+    }
+
+};
+
+#endif // URING_SERVER_HPP